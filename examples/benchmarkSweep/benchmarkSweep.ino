@@ -0,0 +1,125 @@
+/*****************************************************************
+File:         benchmarkSweep.ino
+Description:  Sweep IT_PS/GAIN_PS/IT_ALS/LED current/wait time and
+              measure the achieved PS sample rate, and the IIC transfers,
+              bytes and driver CPU time of a ready read and of a stale
+              poll. Polling is paced to the PS period, so the costs do
+              not depend on how often the loop spins.
+              One CSV line is printed per setting, so the serial log
+              can be compared across library versions.
+******************************************************************/
+#include "BMS33M332.h"
+
+BMS33M332  Alsps(8);   //Select Pin8 as INTPIN
+
+const uint8_t psItList[]   = {IT_PS_96US, IT_PS_192US, IT_PS_384US, IT_PS_768US,
+                              IT_PS_1_54MS, IT_PS_3_07MS, IT_PS_6_14MS};
+const uint8_t psGainList[] = {GAIN_PS_x1, GAIN_PS_x8};
+const uint8_t alsItList[]  = {IT_ALS_25MS, IT_ALS_100MS};
+const uint8_t ledList[]    = {CURRENT_25MA, CURRENT_100MA};
+const uint8_t waitList[]   = {0, 15};   //wait period = (time + 1) * 1.54 ms
+
+#define LIST_LEN(list)     (sizeof(list) / sizeof(list[0]))
+#define MIN_WINDOW_MS      1000         //shortest measuring window
+#define MIN_SAMPLES        8            //window covers at least 8 PS periods
+#define MIN_POLL_US        100          //shortest interval between stale polls
+
+void runSetting(uint8_t psIt, uint8_t psGain, uint8_t alsIt, uint8_t led, uint8_t wait)
+{
+   uint16_t psValue, alsValue;
+   uint32_t period = Alsps.getPSPeriod();
+   uint32_t window = max((uint32_t)MIN_WINDOW_MS, period * MIN_SAMPLES / 1000);
+   uint32_t poll = max((uint32_t)MIN_POLL_US, period / 16);
+   uint32_t samples = 0, readyReads = 0, stalePolls = 0;
+   uint32_t readyCpu = 0, staleCpu = 0;
+   uint32_t readyTrans = 0, readyBytes = 0, staleTrans = 0, staleBytes = 0;
+   uint32_t trans0, bytes0, trans1, bytes1;
+   BMS33M332_TimingStats stats;
+
+   /*discard the sample converted with the previous setting*/
+   delay(period / 1000 + 1);
+   Alsps.readRawIfReady(psValue, alsValue);
+   Alsps.resetTimingStats();
+
+   /*wait until shortly before the next conversion, then poll every poll us*/
+   uint32_t start = millis();
+   uint32_t next = micros();
+   while(millis() - start < window)
+   {
+      while((int32_t)(micros() - next) < 0);
+      Alsps.getBusStats(trans0, bytes0);
+      uint32_t t0 = micros();
+      uint8_t ready = Alsps.readRawIfReady(psValue, alsValue);
+      uint32_t cpu = micros() - t0;
+      Alsps.getBusStats(trans1, bytes1);
+      if(ready != 0)
+      {
+         readyReads++;
+         readyCpu   += cpu;
+         readyTrans += trans1 - trans0;
+         readyBytes += bytes1 - bytes0;
+         next = t0 + period - period / 8;
+      }
+      else
+      {
+         stalePolls++;
+         staleCpu   += cpu;
+         staleTrans += trans1 - trans0;
+         staleBytes += bytes1 - bytes0;
+         next = t0 + poll;
+      }
+      if(ready & FLG_PS_DR)
+      {
+         samples++;
+      }
+   }
+   uint32_t elapsed = millis() - start;
+   Alsps.getTimingStats(stats);
+
+   Serial.print(BMS33M332_LIB_VERSION); Serial.print(',');
+   Serial.print(psIt);     Serial.print(',');
+   Serial.print(psGain);   Serial.print(',');
+   Serial.print(alsIt);    Serial.print(',');
+   Serial.print(led);      Serial.print(',');
+   Serial.print(wait);     Serial.print(',');
+   Serial.print(period);   Serial.print(',');
+   Serial.print(samples);  Serial.print(',');
+   Serial.print(samples * 1000.0 / elapsed, 2);   Serial.print(',');
+   Serial.print(readyReads ? (float)readyTrans / readyReads : 0, 2); Serial.print(',');
+   Serial.print(readyReads ? (float)readyBytes / readyReads : 0, 2); Serial.print(',');
+   Serial.print(readyReads ? readyCpu / readyReads : 0);             Serial.print(',');
+   Serial.print(stalePolls);                                         Serial.print(',');
+   Serial.print(stalePolls ? (float)staleTrans / stalePolls : 0, 2); Serial.print(',');
+   Serial.print(stalePolls ? (float)staleBytes / stalePolls : 0, 2); Serial.print(',');
+   Serial.print(stalePolls ? staleCpu / stalePolls : 0);             Serial.print(',');
+   Serial.print(stats.latencyMean);  Serial.print(',');
+   Serial.println(stats.jitter);
+}
+
+void setup() 
+{
+   Serial.begin(115200);
+   Alsps.begin();
+   Serial.println("lib_version,it_ps,gain_ps,it_als,led,wait,period_us,samples,samples_per_s,"
+                  "transactions_per_sample,bytes_per_sample,cpu_us_per_sample,"
+                  "stale_polls,transactions_per_poll,bytes_per_poll,cpu_us_per_poll,"
+                  "latency_mean_us,jitter_us");
+   for(uint8_t a = 0; a < LIST_LEN(psItList); a++)
+   for(uint8_t b = 0; b < LIST_LEN(psGainList); b++)
+   for(uint8_t c = 0; c < LIST_LEN(alsItList); c++)
+   for(uint8_t d = 0; d < LIST_LEN(ledList); d++)
+   for(uint8_t e = 0; e < LIST_LEN(waitList); e++)
+   {
+      Alsps.setPSIntegrationTime(psItList[a]);
+      Alsps.setPSGain(psGainList[b]);
+      Alsps.setALSIntegrationTime(alsItList[c]);
+      Alsps.setLEDcurrent(ledList[d]);
+      Alsps.setMeasureIntervalTime(waitList[e]);
+      runSetting(psItList[a], psGainList[b], alsItList[c], ledList[d], waitList[e]);
+   }
+   Serial.println("# done");
+}
+
+void loop()
+{
+}
\ No newline at end of file
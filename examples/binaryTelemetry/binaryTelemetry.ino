@@ -0,0 +1,28 @@
+/*****************************************************************
+File:         binaryTelemetry.ino
+Description:  Stream every new PS/ALS sample as a compact binary frame
+              through the serial port. Decode on the PC with
+              extras/decoder/bms33m332_decode.
+******************************************************************/
+#include "BMS33M332.h"
+#include "BMS33M332Stream.h"
+
+BMS33M332  Alsps(8);   //Select Pin8 as INTPIN
+BMS33M332Stream telemetry(&Serial);
+uint16_t alsValue;
+uint16_t psValue;
+
+void setup() 
+{
+   Serial.begin(115200);               
+   Alsps.begin();
+}
+
+void loop()
+{
+   uint8_t ready = Alsps.readRawIfReady(psValue, alsValue);
+   if(ready != 0)
+   {
+      telemetry.write(micros(), psValue, alsValue, ready);
+   }
+}
@@ -0,0 +1,142 @@
+/*****************************************************************
+File:         benchmarkSweep.cpp
+Description:  Host version of examples/benchmarkSweep: the same sweep,
+              pacing and CSV columns, run against the fake register
+              file bus, which converts every getPSPeriod() of the
+              setting. Use it to track driver cost(transfers, bytes,
+              CPU time of a ready read and of a stale poll) across
+              library versions without a module. samples_per_s below
+              1e6/period_us means the paced polling missed samples.
+Build:        make -C extras
+Usage:        extras/build/benchmarkSweep [min_window_ms] > bench.csv
+******************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+#include <thread>
+#include "BMS33M332.h"
+#include "BMS33M332FakeBus.h"
+
+static BMS33M332FakeBus bus;
+static BMS33M332 Alsps(0, &bus);
+
+static const uint8_t psItList[]   = {IT_PS_96US, IT_PS_192US, IT_PS_384US, IT_PS_768US,
+                                     IT_PS_1_54MS, IT_PS_3_07MS, IT_PS_6_14MS};
+static const uint8_t psGainList[] = {GAIN_PS_x1, GAIN_PS_x8};
+static const uint8_t alsItList[]  = {IT_ALS_25MS, IT_ALS_100MS};
+static const uint8_t ledList[]    = {CURRENT_25MA, CURRENT_100MA};
+static const uint8_t waitList[]   = {0, 15};   //wait period = (time + 1) * 1.54 ms
+
+#define LIST_LEN(list)     (sizeof(list) / sizeof(list[0]))
+#define MIN_SAMPLES        8            //window covers at least 8 PS periods
+#define MIN_POLL_US        100          //shortest interval between stale polls
+
+static uint64_t nowUs(clockid_t clock)
+{
+   struct timespec ts;
+   clock_gettime(clock, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void runSetting(uint32_t minWindow, uint8_t psIt, uint8_t psGain, uint8_t alsIt,
+                       uint8_t led, uint8_t wait)
+{
+   uint16_t psValue, alsValue;
+   uint32_t period = Alsps.getPSPeriod();
+   uint64_t window = (uint64_t)period * MIN_SAMPLES;
+   uint32_t poll = (period / 16 > MIN_POLL_US) ? period / 16 : MIN_POLL_US;
+   uint32_t samples = 0, readyReads = 0, stalePolls = 0;
+   uint64_t readyCpu = 0, staleCpu = 0;
+   uint32_t readyTrans = 0, readyBytes = 0, staleTrans = 0, staleBytes = 0;
+   uint32_t trans0, bytes0, trans1, bytes1;
+   BMS33M332_TimingStats stats;
+
+   if(window < (uint64_t)minWindow * 1000)
+   {
+      window = (uint64_t)minWindow * 1000;
+   }
+   bus.setPSPeriod(period);
+   Alsps.readRawIfReady(psValue, alsValue);   //discard the previous setting
+   Alsps.resetTimingStats();
+
+   /*sleep until shortly before the next conversion, then poll every poll us*/
+   uint64_t start = nowUs(CLOCK_MONOTONIC);
+   uint64_t next = start;
+   while(nowUs(CLOCK_MONOTONIC) - start < window)
+   {
+      uint64_t now = nowUs(CLOCK_MONOTONIC);
+      if(now < next)
+      {
+         std::this_thread::sleep_for(std::chrono::microseconds(next - now));
+         now = nowUs(CLOCK_MONOTONIC);
+      }
+      Alsps.getBusStats(trans0, bytes0);
+      uint64_t t0 = nowUs(CLOCK_THREAD_CPUTIME_ID);
+      uint8_t ready = Alsps.readRawIfReady(psValue, alsValue);
+      uint64_t cpu = nowUs(CLOCK_THREAD_CPUTIME_ID) - t0;
+      Alsps.getBusStats(trans1, bytes1);
+      if(ready != 0)
+      {
+         readyReads++;
+         readyCpu   += cpu;
+         readyTrans += trans1 - trans0;
+         readyBytes += bytes1 - bytes0;
+         next = now + period - period / 8;
+      }
+      else
+      {
+         stalePolls++;
+         staleCpu   += cpu;
+         staleTrans += trans1 - trans0;
+         staleBytes += bytes1 - bytes0;
+         next = now + poll;
+      }
+      if(ready & FLG_PS_DR)
+      {
+         samples++;
+      }
+   }
+   uint64_t elapsed = nowUs(CLOCK_MONOTONIC) - start;
+   Alsps.getTimingStats(stats);
+
+   printf("%s,%u,%u,%u,%u,%u,%lu,%lu,%.2f,%.2f,%.2f,%lu,%lu,%.2f,%.2f,%lu,%lu,%lu\n",
+          BMS33M332_LIB_VERSION, psIt, psGain, alsIt, led, wait,
+          (unsigned long)period, (unsigned long)samples,
+          samples * 1000000.0 / elapsed,
+          readyReads ? (double)readyTrans / readyReads : 0.0,
+          readyReads ? (double)readyBytes / readyReads : 0.0,
+          (unsigned long)(readyReads ? readyCpu / readyReads : 0),
+          (unsigned long)stalePolls,
+          stalePolls ? (double)staleTrans / stalePolls : 0.0,
+          stalePolls ? (double)staleBytes / stalePolls : 0.0,
+          (unsigned long)(stalePolls ? staleCpu / stalePolls : 0),
+          (unsigned long)stats.latencyMean, (unsigned long)stats.jitter);
+   fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+   uint32_t minWindow = (argc > 1) ? (uint32_t)atoi(argv[1]) : 1000;
+
+   bus.setLogging(false);
+   Alsps.begin();
+   printf("lib_version,it_ps,gain_ps,it_als,led,wait,period_us,samples,samples_per_s,"
+          "transactions_per_sample,bytes_per_sample,cpu_us_per_sample,"
+          "stale_polls,transactions_per_poll,bytes_per_poll,cpu_us_per_poll,"
+          "latency_mean_us,jitter_us\n");
+   for(uint8_t a = 0; a < LIST_LEN(psItList); a++)
+   for(uint8_t b = 0; b < LIST_LEN(psGainList); b++)
+   for(uint8_t c = 0; c < LIST_LEN(alsItList); c++)
+   for(uint8_t d = 0; d < LIST_LEN(ledList); d++)
+   for(uint8_t e = 0; e < LIST_LEN(waitList); e++)
+   {
+      Alsps.setPSIntegrationTime(psItList[a]);
+      Alsps.setPSGain(psGainList[b]);
+      Alsps.setALSIntegrationTime(alsItList[c]);
+      Alsps.setLEDcurrent(ledList[d]);
+      Alsps.setMeasureIntervalTime(waitList[e]);
+      runSetting(minWindow, psItList[a], psGainList[b], alsItList[c], ledList[d], waitList[e]);
+   }
+   return 0;
+}
@@ -0,0 +1,143 @@
+/*****************************************************************
+File:             BMS33M332Decoder.h
+Author:           BESTMODULES
+Description:      Host-side decoder for the BMS33M332Stream binary
+                  telemetry frames(see src/BMS33M332Frame.h).
+                  Standard C++ only, no Arduino dependency.
+******************************************************************/
+
+#ifndef _BMS33M332DECODER_H_
+#define _BMS33M332DECODER_H_
+
+#include <stdint.h>
+#include "../../src/BMS33M332Frame.h"
+
+typedef struct
+{
+   uint32_t time;      //sample time(unit:us)
+   uint16_t ps;
+   uint16_t als;
+   uint8_t  flags;
+   uint8_t  seq;
+   bool     key;
+} BMS33M332_Record;
+
+class BMS33M332Decoder
+{
+   public:
+   /*Feed one received byte, returns true when rec holds a new record*/
+   bool feed(uint8_t data, BMS33M332_Record &rec)
+   {
+      switch(_state)
+      {
+         case WAIT_SYNC0:
+            if(data == BMS33M332_FRAME_SYNC0) _state = WAIT_SYNC1;
+            return false;
+         case WAIT_SYNC1:
+            _state = (data == BMS33M332_FRAME_SYNC1) ? WAIT_LEN :
+                     (data == BMS33M332_FRAME_SYNC0) ? WAIT_SYNC1 : WAIT_SYNC0;
+            return false;
+         case WAIT_LEN:
+            if(data == 0 || data > BMS33M332_FRAME_MAX_PAYLOAD)
+            {
+               _state = WAIT_SYNC0;
+               return false;
+            }
+            _len = data;
+            _pos = 0;
+            _crc = bms33m332Crc8(0, data);
+            _state = WAIT_PAYLOAD;
+            return false;
+         case WAIT_PAYLOAD:
+            _payload[_pos++] = data;
+            _crc = bms33m332Crc8(_crc, data);
+            if(_pos == _len) _state = WAIT_CRC;
+            return false;
+         case WAIT_CRC:
+         default:
+            _state = WAIT_SYNC0;
+            if(data != _crc)
+            {
+               crcErrors++;
+               return false;
+            }
+            return parse(rec);
+      }
+   }
+
+   void reset()
+   {
+      _state = WAIT_SYNC0;
+      _synced = false;
+   }
+
+   uint32_t frames    = 0;   //records decoded
+   uint32_t crcErrors = 0;   //frames dropped for a bad CRC
+   uint32_t lost      = 0;   //records missing by sequence number
+   uint32_t skipped   = 0;   //delta records dropped while waiting for a key
+
+   private:
+   bool parse(BMS33M332_Record &rec)
+   {
+      uint8_t hdr = _payload[0];
+      uint8_t pos = 1, n = 0;
+      uint32_t time = 0, ps = 0, als = 0;
+      bool key = (hdr & BMS33M332_FRAME_KEY) != 0;
+      uint8_t seq = hdr & BMS33M332_FRAME_SEQ_MASK;
+      uint8_t flags = 0;
+
+      if((n = bms33m332GetVarint(&_payload[pos], _len - pos, &time)) == 0) return false;
+      pos += n;
+      if(pos >= _len) return false;
+      flags = _payload[pos++];
+      if((n = bms33m332GetVarint(&_payload[pos], _len - pos, &ps)) == 0) return false;
+      pos += n;
+      if((n = bms33m332GetVarint(&_payload[pos], _len - pos, &als)) == 0) return false;
+
+      if(_synced)
+      {
+         lost += (uint8_t)(seq - _nextSeq) & BMS33M332_FRAME_SEQ_MASK;
+         if(seq != _nextSeq) _synced = false;
+      }
+      _nextSeq = (seq + 1) & BMS33M332_FRAME_SEQ_MASK;
+      if(key)
+      {
+         _time = time;
+         _ps   = (uint16_t)ps;
+         _als  = (uint16_t)als;
+         _synced = true;
+      }
+      else if(_synced)
+      {
+         _time += time;
+         _ps   = (uint16_t)(_ps + bms33m332UnZigZag(ps));
+         _als  = (uint16_t)(_als + bms33m332UnZigZag(als));
+      }
+      else
+      {
+         skipped++;
+         return false;
+      }
+      rec.time  = _time;
+      rec.ps    = _ps;
+      rec.als   = _als;
+      rec.flags = flags;
+      rec.seq   = seq;
+      rec.key   = key;
+      frames++;
+      return true;
+   }
+
+   enum {WAIT_SYNC0, WAIT_SYNC1, WAIT_LEN, WAIT_PAYLOAD, WAIT_CRC} _state = WAIT_SYNC0;
+   uint8_t  _payload[BMS33M332_FRAME_MAX_PAYLOAD];
+   uint8_t  _len = 0;
+   uint8_t  _pos = 0;
+   uint8_t  _crc = 0;
+   uint8_t  _nextSeq = 0;
+   bool     _synced = false;
+   uint32_t _time = 0;
+   uint16_t _ps   = 0;
+   uint16_t _als  = 0;
+};
+
+#endif
@@ -0,0 +1,37 @@
+/*****************************************************************
+File:         bms33m332_decode.cpp
+Description:  Read BMS33M332Stream frames from a file or stdin
+              (e.g. a serial port) and print one CSV line per record.
+Build:        g++ -O2 -o bms33m332_decode bms33m332_decode.cpp
+Usage:        stty -F /dev/ttyUSB0 115200 raw
+              ./bms33m332_decode /dev/ttyUSB0 > samples.csv
+******************************************************************/
+#include <stdio.h>
+#include "BMS33M332Decoder.h"
+
+int main(int argc, char *argv[])
+{
+   FILE *in = stdin;
+   BMS33M332Decoder decoder;
+   BMS33M332_Record rec;
+   int c;
+
+   if(argc > 1 && (in = fopen(argv[1], "rb")) == NULL)
+   {
+      perror(argv[1]);
+      return 1;
+   }
+   printf("time_us,ps,als,flags\n");
+   while((c = fgetc(in)) != EOF)
+   {
+      if(decoder.feed((uint8_t)c, rec))
+      {
+         printf("%lu,%u,%u,0x%02X\n", (unsigned long)rec.time, rec.ps, rec.als, rec.flags);
+      }
+   }
+   fprintf(stderr, "frames=%lu crc_errors=%lu lost=%lu skipped=%lu\n",
+           (unsigned long)decoder.frames, (unsigned long)decoder.crcErrors,
+           (unsigned long)decoder.lost, (unsigned long)decoder.skipped);
+   if(in != stdin) fclose(in);
+   return 0;
+}
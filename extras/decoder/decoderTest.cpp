@@ -0,0 +1,164 @@
+/*****************************************************************
+File:         decoderTest.cpp
+Description:  Host test of BMS33M332Stream -> BMS33M332Decoder: clean
+              round trip across a micros() wrap with full range
+              deltas, max size varints, a dropped byte, a flipped CRC
+              and delta records skipped until the next key record.
+Build:        make -C extras check
+******************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "BMS33M332Stream.h"
+#include "BMS33M332Decoder.h"
+
+static int failures = 0;
+#define CHECK(cond)  do { if(!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while(0)
+
+#define KEY_INTERVAL  8
+
+typedef std::vector<uint8_t> Frame;
+
+static std::vector<BMS33M332_Record> samples;
+static std::vector<Frame> frames;
+
+/*300 samples starting 2 s before micros() wraps, PS/ALS jumping over the full range*/
+static void makeSamples()
+{
+   BMS33M332Stream stream(NULL, KEY_INTERVAL);
+   uint32_t time = 0xFFFFFFFFUL - 2000000;
+   srand(1);
+   for(int i = 0; i < 300; i++)
+   {
+      BMS33M332_Record rec;
+      uint8_t buf[BMS33M332_FRAME_MAX_LEN];
+      time += 20000 + rand() % 20000;
+      rec.time  = time;
+      rec.ps    = (i % 3 == 0) ? ((i & 1) ? 0xFFFF : 0) : (uint16_t)rand();
+      rec.als   = (i % 5 == 0) ? ((i & 1) ? 0 : 0xFFFF) : (uint16_t)rand();
+      rec.flags = (uint8_t)(i & 0xC1);
+      samples.push_back(rec);
+      uint8_t len = stream.encode(buf, rec.time, rec.ps, rec.als, rec.flags);
+      frames.push_back(Frame(buf, buf + len));
+   }
+}
+
+static bool same(const BMS33M332_Record &a, const BMS33M332_Record &b)
+{
+   return a.time == b.time && a.ps == b.ps && a.als == b.als && a.flags == b.flags;
+}
+
+/*Decode the frames and return the index of each decoded sample*/
+static std::vector<int> decode(const std::vector<Frame> &in, BMS33M332Decoder &decoder)
+{
+   std::vector<int> found;
+   BMS33M332_Record rec;
+   size_t next = 0;
+   for(size_t f = 0; f < in.size(); f++)
+   {
+      for(size_t i = 0; i < in[f].size(); i++)
+      {
+         if(decoder.feed(in[f][i], rec))
+         {
+            while(next < samples.size() && !same(samples[next], rec)) next++;
+            CHECK(next < samples.size());   //decoded value never seen: corrupt record
+            found.push_back((int)next++);
+         }
+      }
+   }
+   return found;
+}
+
+static void testRoundTrip()
+{
+   BMS33M332Decoder decoder;
+   std::vector<int> found = decode(frames, decoder);
+   CHECK(found.size() == samples.size());
+   for(size_t i = 0; i < found.size(); i++)
+   {
+      CHECK(found[i] == (int)i);
+   }
+   CHECK(decoder.frames == samples.size() && decoder.crcErrors == 0);
+   CHECK(decoder.lost == 0 && decoder.skipped == 0);
+   CHECK(samples.back().time < samples.front().time);   //micros() wrapped
+}
+
+static void testMaxVarint()
+{
+   BMS33M332Stream stream(NULL, KEY_INTERVAL);
+   BMS33M332Decoder decoder;
+   BMS33M332_Record rec;
+   uint8_t buf[BMS33M332_FRAME_MAX_LEN];
+   uint8_t len;
+   bool ok = false;
+
+   stream.encode(buf, 0, 0, 0xFFFF, 0);
+   len = stream.encode(buf, 0xFFFFFFFFUL, 0xFFFF, 0, 0xFF);   //5+3+3 byte varints
+   CHECK(len == BMS33M332_FRAME_MAX_LEN);
+   stream.reset();
+   len = stream.encode(buf, 0xFFFFFFFFUL, 0xFFFF, 0xFFFF, 0);   //key record
+   CHECK(len == BMS33M332_FRAME_MAX_LEN);
+   for(uint8_t i = 0; i < len; i++)
+   {
+      ok = decoder.feed(buf[i], rec);
+   }
+   CHECK(ok && rec.key && rec.time == 0xFFFFFFFFUL && rec.ps == 0xFFFF && rec.als == 0xFFFF);
+}
+
+/*After damaging frame bad, nothing wrong is decoded and every record from the next key on is*/
+static void checkResync(const std::vector<int> &found, size_t bad)
+{
+   size_t key = (bad / KEY_INTERVAL + 1) * KEY_INTERVAL;
+   size_t expect = key;
+   for(size_t i = 0; i < found.size(); i++)
+   {
+      if((size_t)found[i] >= key)
+      {
+         CHECK((size_t)found[i] == expect);
+         expect++;
+      }
+      else
+      {
+         CHECK((size_t)found[i] < bad);
+      }
+   }
+   CHECK(expect == samples.size());
+}
+
+static void testDroppedByte()
+{
+   std::vector<Frame> in = frames;
+   BMS33M332Decoder decoder;
+   size_t bad = 2 * KEY_INTERVAL + 3;
+   in[bad].erase(in[bad].begin() + 5);
+   std::vector<int> found = decode(in, decoder);
+   checkResync(found, bad);
+   CHECK(decoder.crcErrors == 1);
+   CHECK(decoder.skipped > 0);
+}
+
+static void testFlippedCrc()
+{
+   std::vector<Frame> in = frames;
+   BMS33M332Decoder decoder;
+   size_t bad = 5 * KEY_INTERVAL + 1;
+   in[bad].back() ^= 0x01;
+   std::vector<int> found = decode(in, decoder);
+   checkResync(found, bad);
+   CHECK(found.size() == samples.size() - (KEY_INTERVAL - 1));
+   CHECK(decoder.crcErrors == 1);
+   CHECK(decoder.lost == 1);
+   CHECK(decoder.skipped == KEY_INTERVAL - 2);   //deltas after the lost one until the key
+}
+
+int main()
+{
+   makeSamples();
+   testRoundTrip();
+   testMaxVarint();
+   testDroppedByte();
+   testFlippedCrc();
+
+   printf("decoderTest: %s(%d failures)\n", failures ? "FAILED" : "passed", failures);
+   return failures ? 1 : 0;
+}
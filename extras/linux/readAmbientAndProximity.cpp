@@ -0,0 +1,35 @@
+/*****************************************************************
+File:         readAmbientAndProximity.cpp
+Description:  Linux version of the readAmbientAndProximity example:
+              print the Ambient and Proximity value of a module on
+              /dev/i2c-N once per second.
+Build:        g++ -O2 -I../../src -o readAmbientAndProximity readAmbientAndProximity.cpp \
+                  ../../src/BMS33M332.cpp ../../src/BMS33M332Bus.cpp ../../src/BMS33M332LinuxBus.cpp
+Usage:        ./readAmbientAndProximity /dev/i2c-1
+              Without a module: modprobe i2c-stub chip_addr=0x47, then
+              use the /dev/i2c-N node of the "SMBus stub driver" adapter.
+******************************************************************/
+#include <stdio.h>
+#include <unistd.h>
+#include "BMS33M332.h"
+#include "BMS33M332LinuxBus.h"
+
+int main(int argc, char *argv[])
+{
+   BMS33M332LinuxBus bus((argc > 1) ? argv[1] : "/dev/i2c-1");
+   BMS33M332 Alsps(0, &bus);   //no INT pin on Linux
+
+   bus.begin();
+   if(bus.isOpen() == false)
+   {
+      perror("open i2c-dev");
+      return 1;
+   }
+   Alsps.begin();
+   while(1)
+   {
+      printf("Data_PS : %u   Data_ALS : %u\n", Alsps.readRawProximity(), Alsps.readRawAmbient());
+      sleep(1);
+   }
+   return 0;
+}
@@ -0,0 +1,220 @@
+/*****************************************************************
+File:             BMS33M332FakeBus.h
+Author:           BESTMODULES
+Description:      In-process BMS33M332Bus simulating the module's
+                  register file, for host tests and benchmarks.
+                  - register address auto increments on read and write
+                  - FLAG_REG bits are write-0-to-clear
+                  - setPSPeriod() runs conversions in real time and
+                    raises FLG_PS_DR/FLG_ALS_DR, convert() does one now
+                  - every transfer is logged and overlapping transfers
+                    (no bus lock) are counted in collisions
+******************************************************************/
+
+#ifndef _BMS33M332FAKEBUS_H_
+#define _BMS33M332FAKEBUS_H_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include "BMS33M332.h"
+
+class BMS33M332FakeBus : public BMS33M332Bus
+{
+   public:
+   typedef struct
+   {
+      bool    read;     //writeRead() if true, write() otherwise
+      uint8_t reg;      //first register
+      uint8_t wlen;     //bytes written, register address included
+      uint8_t rlen;     //bytes read
+      uint8_t data;     //first byte written to reg, 0 for reads
+   } Transfer;
+
+   BMS33M332FakeBus(uint8_t addr = BMS33M332_IICADDR) : _addr(addr)
+   {
+      memset(regs, 0, sizeof(regs));
+      regs[PDT_ID_REG] = 0x52;
+   }
+
+   bool write(uint8_t addr, const uint8_t wbuf[], uint8_t wlen)
+   {
+      enter();
+      bool ack = (addr == _addr && wlen > 0);
+      if(ack)
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         update();
+         uint8_t reg = wbuf[0];
+         for(uint8_t i = 1; i < wlen; i++, reg++)
+         {
+            regs[reg] = (reg == FLAG_REG) ? (regs[reg] & wbuf[i]) : wbuf[i];
+         }
+         if(_logging) _log.push_back(Transfer{false, wbuf[0], wlen, 0, (uint8_t)((wlen > 1) ? wbuf[1] : 0)});
+      }
+      leave();
+      return ack;
+   }
+
+   bool writeRead(uint8_t addr, const uint8_t wbuf[], uint8_t wlen,
+                  uint8_t rbuf[], uint8_t rlen)
+   {
+      enter();
+      bool ack = (addr == _addr && wlen == 1);
+      std::unique_lock<std::mutex> lock(_mutex);
+      if(ack && _nack && wbuf[0] == _nackReg)
+      {
+         _nack = false;
+         ack = false;
+      }
+      if(ack)
+      {
+         update();
+         uint8_t reg = wbuf[0];
+         for(uint8_t i = 0; i < rlen; i++, reg++)
+         {
+            rbuf[i] = regs[reg];
+         }
+         if(wbuf[0] == _raiseReg)
+         {
+            regs[FLAG_REG] |= _raiseFlags;
+            _raiseFlags = 0;
+         }
+         if(_logging) _log.push_back(Transfer{true, wbuf[0], wlen, rlen, 0});
+      }
+      lock.unlock();
+      leave();
+      return ack;
+   }
+
+   /*Run a conversion every period us(0 = only on convert())*/
+   void setPSPeriod(uint32_t period)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _period = period;
+      _last = now();
+   }
+
+   /*Complete one PS+ALS conversion with the given data*/
+   void convert(uint16_t ps, uint16_t als)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      store(ps, als);
+   }
+
+   /*Set FLAG_REG bits right after the next read starting at reg,
+     as the chip would while the driver holds a stale FLAG_REG copy*/
+   void raiseFlagsOnRead(uint8_t reg, uint8_t flags)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _raiseReg = reg;
+      _raiseFlags = flags;
+   }
+
+   /*NACK the next read starting at reg, as on a bus error*/
+   void nackNextRead(uint8_t reg)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _nackReg = reg;
+      _nack = true;
+   }
+
+   uint8_t reg(uint8_t addr)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return regs[addr];
+   }
+
+   void setReg(uint8_t addr, uint8_t data)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      regs[addr] = data;
+   }
+
+   std::vector<Transfer> log()
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _log;
+   }
+
+   /*Stop logging for long runs such as the benchmark*/
+   void setLogging(bool enable)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _logging = enable;
+   }
+
+   void clearLog()
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _log.clear();
+   }
+
+   std::atomic<uint32_t> collisions{0};   //transfers that overlapped another
+   std::atomic<uint32_t> conversions{0};
+
+   private:
+   static uint64_t now()
+   {
+      return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+   }
+
+   void enter()
+   {
+      if(_busy.fetch_add(1) != 0)
+      {
+         collisions++;
+      }
+      std::this_thread::yield();   //widen the window an unlocked caller can hit
+   }
+
+   void leave()
+   {
+      _busy--;
+   }
+
+   void update()
+   {
+      if(_period == 0)
+      {
+         return;
+      }
+      uint64_t t = now();
+      if(t - _last >= _period)
+      {
+         _last += (t - _last) / _period * _period;
+         _ps++;
+         store(_ps, (uint16_t)(_ps * 3));
+      }
+   }
+
+   void store(uint16_t ps, uint16_t als)
+   {
+      regs[DATA1_PS_REG]  = ps >> 8;
+      regs[DATA2_PS_REG]  = (uint8_t)ps;
+      regs[DATA1_ALS_REG] = als >> 8;
+      regs[DATA2_ALS_REG] = (uint8_t)als;
+      regs[FLAG_REG] |= FLG_PS_DR | FLG_ALS_DR;
+      conversions++;
+   }
+
+   uint8_t  regs[256];
+   uint8_t  _addr;
+   uint32_t _period = 0;
+   uint64_t _last = 0;
+   uint16_t _ps = 0;
+   uint8_t  _raiseReg = 0;
+   uint8_t  _raiseFlags = 0;
+   uint8_t  _nackReg = 0;
+   bool     _nack = false;
+   bool     _logging = true;
+   std::mutex _mutex;
+   std::atomic<int> _busy{0};
+   std::vector<Transfer> _log;
+};
+
+#endif
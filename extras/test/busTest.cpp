@@ -0,0 +1,177 @@
+/*****************************************************************
+File:         busTest.cpp
+Description:  Host test of the BMS33M332 register access pattern on
+              the fake register file bus: one writeRead per register
+              read, one burst write per threshold setter, data ready
+              gated reads and captureBurst() restore.
+Build:        make -C extras check
+******************************************************************/
+#include <stdio.h>
+#include "BMS33M332.h"
+#include "BMS33M332FakeBus.h"
+
+static int failures = 0;
+#define CHECK(cond)  do { if(!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while(0)
+
+typedef BMS33M332FakeBus::Transfer Transfer;
+
+static void testReadReg(BMS33M332FakeBus &bus, BMS33M332 &sensor)
+{
+   uint8_t buf[2];
+   bus.clearLog();
+   CHECK(sensor.readReg(PDT_ID_REG) == 0x52);
+   sensor.readReg(THDH1_PS_REG, buf, 2);
+   sensor.readRawProximity();
+   std::vector<Transfer> log = bus.log();
+   CHECK(log.size() == 3);
+   for(size_t i = 0; i < log.size(); i++)
+   {
+      CHECK(log[i].read && log[i].wlen == 1);
+   }
+   CHECK(log[0].reg == PDT_ID_REG && log[0].rlen == 1);
+   CHECK(log[1].reg == THDH1_PS_REG && log[1].rlen == 2);
+   CHECK(log[2].reg == DATA1_PS_REG && log[2].rlen == 2);
+}
+
+static void testBurstWrites(BMS33M332FakeBus &bus, BMS33M332 &sensor)
+{
+   std::vector<Transfer> log;
+
+   bus.clearLog();
+   sensor.setINT(0x0102, 0x0304);
+   log = bus.log();
+   CHECK(log.size() == 2);
+   CHECK(!log[0].read && log[0].reg == INTCTRL1_REG && log[0].wlen == 2);
+   CHECK(!log[1].read && log[1].reg == THDH1_PS_REG && log[1].wlen == 5);
+   CHECK(sensor.getPSHighThreshold() == 0x0102 && sensor.getPSLowThreshold() == 0x0304);
+
+   const uint8_t regs[4] = {THDH1_PS_REG, THDL1_PS_REG, THDH1_ALS_REG, THDL1_ALS_REG};
+   for(uint8_t i = 0; i < 4; i++)
+   {
+      uint16_t thd = 0x1100 + i;
+      bus.clearLog();
+      switch(i)
+      {
+         case 0: sensor.setPSHighThreshold(thd);  break;
+         case 1: sensor.setPSLowThreshold(thd);   break;
+         case 2: sensor.setALSHighThreshold(thd); break;
+         case 3: sensor.setALSLowThreshold(thd);  break;
+      }
+      log = bus.log();
+      CHECK(log.size() == 1);
+      CHECK(!log[0].read && log[0].reg == regs[i] && log[0].wlen == 3);
+      CHECK(bus.reg(regs[i]) == 0x11 && bus.reg(regs[i] + 1) == i);
+   }
+}
+
+static void testReadIfReady(BMS33M332FakeBus &bus, BMS33M332 &sensor)
+{
+   uint16_t ps = 0xFFFF, als = 0xFFFF;
+   std::vector<Transfer> log;
+
+   bus.setReg(FLAG_REG, 0);
+   bus.clearLog();
+   CHECK(sensor.readRawIfReady(ps, als) == 0);
+   log = bus.log();
+   CHECK(log.size() == 1 && log[0].reg == FLAG_REG);
+   CHECK(ps == 0xFFFF && als == 0xFFFF);
+
+   /*both ready: FLAG read, one FLAG clear, one 4 byte data read*/
+   bus.convert(0x1234, 0x5678);
+   bus.setReg(FLAG_REG, bus.reg(FLAG_REG) | 0x10);   //FLG_PS_INT pending
+   bus.clearLog();
+   CHECK(sensor.readRawIfReady(ps, als) == (FLG_PS_DR | FLG_ALS_DR));
+   log = bus.log();
+   CHECK(log.size() == 3);
+   CHECK(!log[1].read && log[1].reg == FLAG_REG);
+   CHECK(log[2].read && log[2].reg == DATA1_PS_REG && log[2].rlen == 4);
+   CHECK(ps == 0x1234 && als == 0x5678);
+   CHECK(bus.reg(FLAG_REG) == 0x10);   //only the consumed DR bits cleared
+
+   /*PS only read keeps FLG_ALS_DR for readRawAmbientIfReady()*/
+   bus.convert(0x0001, 0x0002);
+   CHECK(sensor.readRawProximityIfReady(ps) && ps == 0x0001);
+   CHECK((bus.reg(FLAG_REG) & (FLG_PS_DR | FLG_ALS_DR)) == FLG_ALS_DR);
+
+   /*flags raised after the FLAG_REG read survive*/
+   CHECK(sensor.readRawAmbientIfReady(als));
+   bus.setReg(FLAG_REG, FLG_PS_DR);
+   bus.raiseFlagsOnRead(DATA1_PS_REG, FLG_ALS_DR | 0x20);   //+FLG_ALS_INT
+   CHECK(sensor.readRawProximityIfReady(ps));
+   CHECK(bus.reg(FLAG_REG) == (FLG_ALS_DR | 0x20));
+   bus.setReg(FLAG_REG, 0);
+   bus.convert(0x0001, 0x0002);
+   CHECK(sensor.readRawProximityIfReady(ps));
+   CHECK(sensor.readRawAmbientIfReady(als) && als == 0x0002);
+   CHECK(sensor.readRawAmbientIfReady(als) == false);
+
+   /*a conversion completing during the data read is not lost*/
+   bus.convert(100, 0);
+   bus.raiseFlagsOnRead(DATA1_PS_REG, FLG_PS_DR);
+   CHECK(sensor.readRawProximityIfReady(ps) && ps == 100);
+   bus.setReg(DATA1_PS_REG, 0);
+   bus.setReg(DATA2_PS_REG, 101);
+   CHECK(sensor.readRawProximityIfReady(ps) && ps == 101);
+   CHECK(sensor.readRawProximityIfReady(ps) == false);
+   bus.setReg(FLAG_REG, 0);
+}
+
+static void testPSPeriod(BMS33M332 &sensor)
+{
+   /*begin(): EN_PS, EN_ALS, EN_WAIT(WAIT_REG 0), IT_PS 96us, IT_ALS 25ms;
+     the intelligent wait is not part of the period*/
+   CHECK(sensor.getPSPeriod() == 96 + 25000 + 1540);
+   sensor.setMeasureIntervalTime(9);
+   CHECK(sensor.getPSPeriod() == 96 + 25000 + 10 * 1540);
+   sensor.setMeasureIntervalTime(0);
+}
+
+static void testCaptureBurst(BMS33M332FakeBus &bus, BMS33M332 &sensor)
+{
+   uint16_t ps[8], als[8];
+   uint8_t state = bus.reg(STATE_REG);
+   uint8_t psCtrl = bus.reg(PSCTRL_REG);
+   bus.convert(0x0A0B, 0x0C0D);
+   CHECK(sensor.captureBurst(ps, als, 8, 200) > 0);
+   for(int i = 0; i < 8; i++)
+   {
+      CHECK(ps[i] == 0x0A0B && als[i] == 0x0C0D);
+   }
+   CHECK(bus.reg(STATE_REG) == state && bus.reg(PSCTRL_REG) == psCtrl);
+
+   /*default period from the burst configuration: PS only, no waits*/
+   CHECK(state & (1<<EN_INTELLI_WAIT));
+   bus.clearLog();
+   CHECK(sensor.captureBurst(ps, NULL, 4) > 0);
+   std::vector<Transfer> log = bus.log();
+   for(size_t i = 0; i < log.size(); i++)
+   {
+      if(!log[i].read && log[i].reg == STATE_REG)
+      {
+         CHECK(log[i].data == (state & ~((1<<EN_WAIT) | (1<<EN_INTELLI_WAIT) | (1<<EN_ALS))));
+         break;
+      }
+   }
+   CHECK(bus.reg(STATE_REG) == state);
+
+   /*a failed read is reported, not passed off as a 0 reading*/
+   bus.nackNextRead(DATA1_PS_REG);
+   CHECK(sensor.captureBurst(ps, als, 4, 200) == 0);
+   CHECK(ps[0] == 0 && ps[1] == 0x0A0B);
+}
+
+int main()
+{
+   BMS33M332FakeBus bus;
+   BMS33M332 sensor(0, &bus);
+   sensor.begin();
+
+   testReadReg(bus, sensor);
+   testBurstWrites(bus, sensor);
+   testReadIfReady(bus, sensor);
+   testPSPeriod(sensor);
+   testCaptureBurst(bus, sensor);
+
+   printf("busTest: %s(%d failures)\n", failures ? "FAILED" : "passed", failures);
+   return failures ? 1 : 0;
+}
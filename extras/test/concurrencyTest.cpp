@@ -0,0 +1,307 @@
+/*****************************************************************
+File:         concurrencyTest.cpp
+Description:  Host test of the bus lock: threads driving two BMS33M332
+              instances and a foreign driver on one fake bus, sharing
+              one BMS33M332StdLock. Every transfer is traced with the
+              lock hold it ran in, and each hold must reach the bus as
+              one uninterrupted run: writeRegBit() read-modify-write,
+              readDataIfReady() check/read/clear and captureBurst()
+              save/restore.
+Build:        make -C extras check
+******************************************************************/
+#include <stdio.h>
+#include <algorithm>
+#include <set>
+#include <thread>
+#include "BMS33M332.h"
+#include "BMS33M332FakeBus.h"
+
+static std::atomic<int> failures{0};   //CHECK runs on the test threads too
+#define CHECK(cond)  do { if(!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while(0)
+
+#define LOOPS  400
+
+/*Numbers each outermost hold of the lock*/
+class TraceLock : public BMS33M332StdLock
+{
+   public:
+   void lock()
+   {
+      BMS33M332StdLock::lock();
+      if(_held++ == 0) _hold = ++_holds;
+   }
+   void unlock()
+   {
+      _held--;
+      BMS33M332StdLock::unlock();
+   }
+   /*Hold of the calling thread, 0 if it does not hold the lock*/
+   uint32_t hold() { return (_held > 0) ? _hold : 0; }
+
+   private:
+   static thread_local int _held;
+   uint32_t _hold = 0;
+   uint32_t _holds = 0;
+};
+thread_local int TraceLock::_held = 0;
+
+typedef struct
+{
+   uint32_t hold;
+   std::thread::id thread;
+   bool    read;
+   uint8_t reg;
+   uint8_t len;      //bytes written after the address, or bytes read
+} Entry;
+
+static std::mutex traceMutex;
+static std::vector<Entry> trace;
+
+/*Forwards to the shared fake and traces each transfer*/
+class TraceBus : public BMS33M332Bus
+{
+   public:
+   TraceBus(BMS33M332FakeBus &bus, TraceLock &lock) : _bus(bus), _lock(lock) {}
+   bool write(uint8_t addr, const uint8_t wbuf[], uint8_t wlen)
+   {
+      bool ack = _bus.write(addr, wbuf, wlen);
+      record(false, wbuf[0], wlen - 1);
+      return ack;
+   }
+   bool writeRead(uint8_t addr, const uint8_t wbuf[], uint8_t wlen,
+                  uint8_t rbuf[], uint8_t rlen)
+   {
+      bool ack = _bus.writeRead(addr, wbuf, wlen, rbuf, rlen);
+      record(true, wbuf[0], rlen);
+      return ack;
+   }
+
+   private:
+   void record(bool read, uint8_t reg, uint8_t len)
+   {
+      std::lock_guard<std::mutex> lock(traceMutex);
+      trace.push_back(Entry{_lock.hold(), std::this_thread::get_id(), read, reg, len});
+   }
+   BMS33M332FakeBus &_bus;
+   TraceLock &_lock;
+};
+
+static bool covers(const Entry &e, uint8_t reg)
+{
+   return reg >= e.reg && reg < e.reg + e.len;
+}
+
+/*Every transfer ran under the lock and no hold was interleaved with another*/
+static void checkHolds()
+{
+   std::set<uint32_t> done;
+   uint32_t hold = 0;
+   for(size_t i = 0; i < trace.size(); i++)
+   {
+      CHECK(trace[i].hold != 0);
+      if(trace[i].hold != hold)
+      {
+         done.insert(hold);
+         hold = trace[i].hold;
+         CHECK(done.count(hold) == 0);
+      }
+   }
+}
+
+/*Single register writes of rmw registers follow a read of the register
+  in the same hold(captureBurst() restore excepted)*/
+static void checkReadModifyWrite(std::thread::id skip)
+{
+   const uint8_t rmw[4] = {PSCTRL_REG, ALSCTRL_REG, LEDCTRL_REG, FLAG_REG};
+   for(size_t i = 0; i < trace.size(); i++)
+   {
+      const Entry &e = trace[i];
+      if(e.read || e.len != 1 || e.thread == skip ||
+         std::find(rmw, rmw + 4, e.reg) == rmw + 4)
+      {
+         continue;
+      }
+      bool found = false;
+      for(size_t j = i; j-- > 0 && trace[j].hold == e.hold; )
+      {
+         found |= (trace[j].read && covers(trace[j], e.reg));
+      }
+      CHECK(found);
+   }
+}
+
+/*Consumes samples, each returned with the ALS of the same conversion*/
+static void reader(BMS33M332 *sensor, bool both, std::vector<uint16_t> *seen)
+{
+   for(int i = 0; i < LOOPS; i++)
+   {
+      uint16_t ps = 0, als = 0;
+      uint8_t ready = both ? sensor->readRawIfReady(ps, als)
+                           : (sensor->readRawProximityIfReady(ps) ? FLG_PS_DR : 0);
+      if(ready & FLG_PS_DR)
+      {
+         seen->push_back(ps);
+         if(ready & FLG_ALS_DR) CHECK(als == (uint16_t)(ps * 3));
+      }
+   }
+}
+
+/*Reads the timing statistics while readers record samples*/
+static void statsReader(BMS33M332 *sensor)
+{
+   uint32_t count = 0;
+   for(int i = 0; i < LOOPS; i++)
+   {
+      BMS33M332_TimingStats stats;
+      sensor->getTimingStats(stats);
+      CHECK(stats.count >= count);
+      if(stats.count > 0)
+      {
+         CHECK(stats.latencyMin <= stats.latencyMean && stats.latencyMean <= stats.latencyMax);
+      }
+      if(stats.count > 1)
+      {
+         CHECK(stats.intervalMin <= stats.intervalMean && stats.intervalMean <= stats.intervalMax);
+      }
+      count = stats.count;
+   }
+}
+
+/*Another driver on the same port: its guarded pair must stay together*/
+static void foreignDriver(TraceBus *bus, TraceLock *lock)
+{
+   const uint8_t reg = PDT_ID_REG;
+   uint8_t id = 0;
+   for(int i = 0; i < LOOPS; i++)
+   {
+      BMS33M332BusGuard guard(lock);
+      bus->writeRead(BMS33M332_IICADDR, &reg, 1, &id, 1);
+      bus->writeRead(BMS33M332_IICADDR, &reg, 1, &id, 1);
+   }
+}
+
+/*A conversion completing during a data read is returned for that DR and
+  again for its own DR, never more often*/
+static void checkSamples(std::vector<uint16_t> *seen, int n)
+{
+   std::vector<uint16_t> all;
+   for(int i = 0; i < n; i++)
+   {
+      all.insert(all.end(), seen[i].begin(), seen[i].end());
+   }
+   std::sort(all.begin(), all.end());
+   CHECK(!all.empty());
+   for(size_t i = 2; i < all.size(); i++)
+   {
+      CHECK(all[i] != all[i - 2]);
+   }
+}
+
+static void testSettersAndReaders(BMS33M332FakeBus &bus, BMS33M332 &a, BMS33M332 &b,
+                                  TraceBus &other, TraceLock &lock)
+{
+   std::vector<uint16_t> seen[2];
+   trace.clear();
+   bus.setPSPeriod(200);
+   std::vector<std::thread> threads;
+   /*setters touching different bits of the same registers, from both instances*/
+   threads.push_back(std::thread([&] { for(int i = LOOPS; i >= 0; i--) a.setPSIntegrationTime(i % 7); }));
+   threads.push_back(std::thread([&] { for(int i = LOOPS; i >= 0; i--) b.setPSGain((i + 3) % 4); }));
+   threads.push_back(std::thread([&] { for(int i = LOOPS; i >= 0; i--) b.setALSIntegrationTime(i % 7); }));
+   threads.push_back(std::thread([&] { for(int i = LOOPS; i >= 0; i--) a.setALSGain((i + 2) % 4); }));
+   threads.push_back(std::thread([&] { for(int i = LOOPS; i >= 0; i--) a.setLEDcurrent(i % 8); }));
+   threads.push_back(std::thread(reader, &a, true, &seen[0]));
+   threads.push_back(std::thread(reader, &b, false, &seen[1]));
+   threads.push_back(std::thread(statsReader, &a));
+   threads.push_back(std::thread(foreignDriver, &other, &lock));
+   for(size_t i = 0; i < threads.size(); i++)
+   {
+      threads[i].join();
+   }
+   bus.setPSPeriod(0);
+
+   CHECK(bus.collisions == 0);
+   checkHolds();
+   checkReadModifyWrite(std::thread::id());
+   checkSamples(seen, 2);
+   /*no read-modify-write lost another thread's bits*/
+   CHECK((bus.reg(PSCTRL_REG) & 0x3F) == ((GAIN_PS_x8 << 4) | IT_PS_96US));
+   CHECK((bus.reg(ALSCTRL_REG) & 0x3F) == ((GAIN_ALS_x16 << 4) | IT_ALS_25MS));
+   CHECK((bus.reg(LEDCTRL_REG) >> 5) == 0);
+}
+
+static void testCaptureWithTraffic(BMS33M332FakeBus &bus, BMS33M332 &a, BMS33M332 &b,
+                                   TraceBus &other, TraceLock &lock)
+{
+   std::vector<uint16_t> seen[1];
+   uint16_t ps[16], als[16];
+   uint8_t state = bus.reg(STATE_REG);
+   uint8_t psCtrl = bus.reg(PSCTRL_REG);
+   std::thread::id capture;
+   trace.clear();
+   bus.setPSPeriod(200);
+   std::vector<std::thread> threads;
+   threads.push_back(std::thread([&] { a.captureBurst(ps, als, 16, 500); }));
+   capture = threads[0].get_id();
+   threads.push_back(std::thread(reader, &b, true, &seen[0]));
+   threads.push_back(std::thread([&] { for(int i = LOOPS; i >= 0; i--) b.setLEDcurrent(i % 8); }));
+   threads.push_back(std::thread(foreignDriver, &other, &lock));
+   for(size_t i = 0; i < threads.size(); i++)
+   {
+      threads[i].join();
+   }
+   bus.setPSPeriod(0);
+
+   CHECK(bus.collisions == 0);
+   checkHolds();
+   checkReadModifyWrite(capture);
+   checkSamples(seen, 1);
+   CHECK(bus.reg(STATE_REG) == state && bus.reg(PSCTRL_REG) == psCtrl);
+
+   /*the burst configuration is read and written within one hold,
+     and restored within one hold*/
+   std::vector<Entry> mine;
+   for(size_t i = 0; i < trace.size(); i++)
+   {
+      if(trace[i].thread == capture) mine.push_back(trace[i]);
+   }
+   CHECK(mine.size() > 4);
+   if(mine.size() > 4)
+   {
+      uint32_t save = mine.front().hold, restore = mine.back().hold;
+      bool readCtrl = false, wroteCtrl = false;
+      for(size_t i = 0; i < mine.size() && mine[i].hold == save; i++)
+      {
+         readCtrl  |= (mine[i].read && covers(mine[i], PSCTRL_REG));
+         wroteCtrl |= (!mine[i].read && mine[i].reg == PSCTRL_REG && readCtrl);
+      }
+      CHECK(wroteCtrl);
+      const Entry &last = mine[mine.size() - 1], &prev = mine[mine.size() - 2];
+      CHECK(prev.hold == restore && !prev.read && prev.reg == PSCTRL_REG);
+      CHECK(!last.read && last.reg == STATE_REG);
+   }
+}
+
+int main()
+{
+   BMS33M332FakeBus bus;
+   TraceLock lock;
+   TraceBus busA(bus, lock), busB(bus, lock), other(bus, lock);
+   BMS33M332 a(0, &busA), b(0, &busB);
+   bus.setLogging(false);
+   a.setBusLock(&lock);
+   b.setBusLock(&lock);
+   a.begin();
+   b.begin();
+
+   testSettersAndReaders(bus, a, b, other, lock);
+   testCaptureWithTraffic(bus, a, b, other, lock);
+
+   /*a NULL lock is skipped*/
+   {
+      BMS33M332BusGuard guard((BMS33M332Lock *)NULL);
+   }
+
+   printf("concurrencyTest: %s(%d failures)\n", failures ? "FAILED" : "passed", (int)failures);
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/*****************************************************************
+File:         linuxBusTest.cpp
+Description:  Host test of BMS33M332LinuxBus against the kernel's
+              i2c-stub(SMBus only adapter, I2C_SMBUS path):
+                modprobe i2c-stub chip_addr=0x47
+                make -C extras check
+              A burst write and a 4 byte read are round-tripped
+              directly and through the BMS33M332 threshold setters.
+              Skipped when no i2c-stub adapter is present; pass a
+              /dev/i2c-N node to test another adapter(I2C_RDWR path)
+              with a scratch device at 0x47.
+Build:        make -C extras check
+******************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <string>
+#include "BMS33M332.h"
+#include "BMS33M332LinuxBus.h"
+
+static int failures = 0;
+#define CHECK(cond)  do { if(!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while(0)
+
+#define NO_DEVICE_ADDR  0x08   //no i2c-stub chip there
+
+/*Find the /dev node of the i2c-stub adapter, empty if not loaded*/
+static std::string findStub()
+{
+   std::string node;
+   DIR *dir = opendir("/sys/class/i2c-dev");
+   struct dirent *entry;
+   if(dir == NULL)
+   {
+      return node;
+   }
+   while(node.empty() && (entry = readdir(dir)) != NULL)
+   {
+      char name[64] = {0};
+      std::string path = std::string("/sys/class/i2c-dev/") + entry->d_name + "/name";
+      FILE *file = fopen(path.c_str(), "r");
+      if(file == NULL)
+      {
+         continue;
+      }
+      if(fgets(name, sizeof(name), file) != NULL && strncmp(name, "SMBus stub driver", 17) == 0)
+      {
+         node = std::string("/dev/") + entry->d_name;
+      }
+      fclose(file);
+   }
+   closedir(dir);
+   return node;
+}
+
+static void testRawTransfers(BMS33M332LinuxBus &bus)
+{
+   const uint8_t wbuf[5] = {THDH1_PS_REG, 0x12, 0x34, 0x56, 0x78};
+   const uint8_t reg = THDH1_PS_REG;
+   uint8_t rbuf[4] = {0};
+
+   CHECK(bus.write(BMS33M332_IICADDR, wbuf, 5));
+   CHECK(bus.writeRead(BMS33M332_IICADDR, &reg, 1, rbuf, 4));
+   CHECK(memcmp(rbuf, &wbuf[1], 4) == 0);
+   CHECK(bus.write(BMS33M332_IICADDR, &reg, 1));   //register pointer only
+
+   /*NACK leaves rbuf unchanged*/
+   memset(rbuf, 0xA5, 4);
+   CHECK(bus.writeRead(NO_DEVICE_ADDR, &reg, 1, rbuf, 4) == false);
+   CHECK(rbuf[0] == 0xA5 && rbuf[3] == 0xA5);
+   CHECK(bus.write(NO_DEVICE_ADDR, wbuf, 5) == false);
+   CHECK(bus.write(BMS33M332_IICADDR, wbuf, 5));   //slave address switched back
+}
+
+static void testDriver(BMS33M332LinuxBus &bus)
+{
+   BMS33M332 sensor(0, &bus);
+   uint32_t transactions, bytes;
+
+   sensor.begin();   //read-modify-writes on the stub's register file
+   CHECK(sensor.readReg(STATE_REG) & (1<<EN_PS));
+   CHECK(sensor.readReg(LEDCTRL_REG) >> 5 == CURRENT_100MA);
+   sensor.setINT(0x0102, 0x0304);
+   CHECK(sensor.getPSHighThreshold() == 0x0102);
+   CHECK(sensor.getPSLowThreshold() == 0x0304);
+   sensor.setALSHighThreshold(0xBEEF);
+   CHECK(sensor.getALSHighThreshold() == 0xBEEF);
+   sensor.getBusStats(transactions, bytes);
+   CHECK(transactions > 0 && bytes > 0);
+}
+
+int main(int argc, char *argv[])
+{
+   std::string node = (argc > 1) ? argv[1] : findStub();
+   if(node.empty())
+   {
+      printf("linuxBusTest: skipped(no i2c-stub, modprobe i2c-stub chip_addr=0x47)\n");
+      return 0;
+   }
+   BMS33M332LinuxBus bus(node.c_str());
+   bus.begin();
+   if(bus.isOpen() == false)
+   {
+      printf("linuxBusTest: skipped(cannot open %s)\n", node.c_str());
+      return 0;
+   }
+
+   testRawTransfers(bus);
+   testDriver(bus);
+
+   printf("linuxBusTest: %s(%d failures, %s)\n", failures ? "FAILED" : "passed", failures, node.c_str());
+   return failures ? 1 : 0;
+}
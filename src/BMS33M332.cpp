@@ -6,6 +6,10 @@ History:
 V1.0.1   -- initial version；2021-06-25；Arduino IDE :v1.8.15
 ******************************************************************/
 #include "BMS33M332.h"
+#if !defined(ARDUINO)
+#include "BMS33M332Port.h"
+#endif
+#if defined(ARDUINO)
 /**********************************************************
 Description: Constructor
 Parameters:  intPin :INT Output pin connection with Arduino 
@@ -13,10 +17,23 @@ Parameters:  intPin :INT Output pin connection with Arduino
 Return:      none    
 Others:      none
 **********************************************************/
-BMS33M332::BMS33M332(uint8_t intPin,TwoWire *theWire)
+BMS33M332::BMS33M332(uint8_t intPin,TwoWire *theWire) : _wireBus(theWire)
 {
      _intPin = intPin;
-     _wire = theWire;
+     _bus = &_wireBus;
+}
+#endif
+/**********************************************************
+Description: Constructor
+Parameters:  intPin :INT Output pin connection with Arduino 
+             bus : IIC bus implementation, e.g. BMS33M332LinuxBus        
+Return:      none    
+Others:      bus must outlive this object
+**********************************************************/
+BMS33M332::BMS33M332(uint8_t intPin,BMS33M332Bus *bus)
+{
+     _intPin = intPin;
+     _bus = bus;
 }
 /**********************************************************
 Description: Module Initial
@@ -28,7 +45,7 @@ void BMS33M332::begin(uint8_t addr)
 {
       pinMode(_intPin,INPUT);
       _i2caddr = addr;
-      _wire->begin(); 
+      _bus->begin(); 
       /*-------STATE_REG 0x00---------*/
       writeRegBit(STATE_REG, EN_PS, ENABLE);//Enable EN_PS
       writeRegBit(STATE_REG, EN_ALS, ENABLE);//Enable EN_ALS
@@ -53,8 +70,9 @@ Others:      none
 uint16_t BMS33M332::readRawProximity()
 {
       uint16_t psValue = 0;
-      readReg(DATA1_PS_REG,dataBuff,2);
-      psValue = ((uint16_t)dataBuff[0]<<8 | dataBuff[1]);
+      uint8_t rBuf[2] = {0};
+      readReg(DATA1_PS_REG,rBuf,2);
+      psValue = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
       return psValue;
 }
 /**********************************************************
@@ -66,8 +84,9 @@ Others:      none
 uint16_t BMS33M332::readRawAmbient()
 {   
       uint16_t alsValue = 0;
-      readReg(DATA1_ALS_REG,dataBuff,2);
-      alsValue = ((uint16_t)dataBuff[0]<<8 | dataBuff[1]);
+      uint8_t rBuf[2] = {0};
+      readReg(DATA1_ALS_REG,rBuf,2);
+      alsValue = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
       return alsValue;
 }
 /**********************************************************
@@ -86,6 +105,214 @@ float BMS33M332::readAmbient()
       return ambient;   
 }
 /**********************************************************
+Description: get PS ADC raw data only if a new conversion is ready
+Parameters:  psValue:Variables for storing PS data(unchanged if not ready)
+Return:      true : psValue holds a new sample, FLG_PS_DR cleared
+             false: no conversion since the last read, no data transfer
+Others:      Costs a single FLAG_REG read while the data is stale
+**********************************************************/
+bool BMS33M332::readRawProximityIfReady(uint16_t &psValue)
+{
+      uint16_t alsValue = 0;
+      return readDataIfReady(FLG_PS_DR, psValue, alsValue) != 0;
+}
+/**********************************************************
+Description: get ALS ADC raw data only if a new conversion is ready
+Parameters:  alsValue:Variables for storing ALS data(unchanged if not ready)
+Return:      true : alsValue holds a new sample, FLG_ALS_DR cleared
+             false: no conversion since the last read, no data transfer
+Others:      Costs a single FLAG_REG read while the data is stale
+**********************************************************/
+bool BMS33M332::readRawAmbientIfReady(uint16_t &alsValue)
+{
+      uint16_t psValue = 0;
+      return readDataIfReady(FLG_ALS_DR, psValue, alsValue) != 0;
+}
+/**********************************************************
+Description: get PS and ALS ADC raw data that completed since the last read
+Parameters:  psValue :Variables for storing PS data(unchanged if not ready)
+             alsValue:Variables for storing ALS data(unchanged if not ready)
+Return:      Data ready mask of the values updated:
+               FLG_PS_DR  : psValue updated
+               FLG_ALS_DR : alsValue updated
+               0          : nothing new, only FLAG_REG was read
+Others:      DATA_PS/DATA_ALS follow FLAG_REG, so the ready channels are
+             fetched in one burst and both DR flags are cleared with a
+             single write.
+**********************************************************/
+uint8_t BMS33M332::readRawIfReady(uint16_t &psValue,uint16_t &alsValue)
+{
+      return readDataIfReady(FLG_PS_DR | FLG_ALS_DR, psValue, alsValue);
+}
+/**********************************************************
+Description: get the expected PS conversion period
+Parameters:  none
+Return:      PS period(unit:us) of the current configuration
+Others:      Read from the chip, power-on defaults included. One cycle is
+             PS integration + ALS integration(if EN_ALS) + wait period
+             (if EN_WAIT, (WAIT_REG+1)*1.54 ms). The intelligent wait
+             only applies while a PS persistence count is pending, so
+             it is not included.
+**********************************************************/
+uint32_t BMS33M332::getPSPeriod()
+{
+      uint32_t period = 0;
+      uint8_t rBuf[6] = {0};   //STATE_REG~WAIT_REG
+      uint8_t psIt = 0, alsIt = 0;
+      readReg(STATE_REG,rBuf,6);
+      psIt  = rBuf[PSCTRL_REG] & 0x0F;
+      alsIt = rBuf[ALSCTRL_REG] & 0x0F;
+      if(rBuf[STATE_REG] & (1<<EN_PS))
+      {
+            period += (uint32_t)96 << ((psIt <= IT_PS_6_14MS) ? psIt : IT_PS_96US);       //96us~6.14ms
+      }
+      if(rBuf[STATE_REG] & (1<<EN_ALS))
+      {
+            period += (uint32_t)25000 << ((alsIt <= IT_ALS_1600MS) ? alsIt : IT_ALS_100MS); //25ms~1600ms
+      }
+      if(rBuf[STATE_REG] & (1<<EN_WAIT))
+      {
+            period += ((uint32_t)rBuf[WAIT_REG] + 1) * 1540;
+      }
+      return period;
+}
+/**********************************************************
+Description: get host timestamps of the last PS sample
+Parameters:  readyTime:micros() at the start of the FLAG_REG read that
+                       found FLG_PS_DR
+             doneTime :micros() when the PS data read completed
+Return:      none
+Others:      Only samples taken through readRawProximityIfReady()
+             /readRawIfReady() are timestamped. The conversion ended
+             at most one polling interval before readyTime.
+**********************************************************/
+void BMS33M332::getLastPSSampleTime(uint32_t &readyTime,uint32_t &doneTime)
+{
+      BMS33M332BusGuard guard(_bus);
+      readyTime = _psReadyTime;
+      doneTime  = _psDoneTime;
+}
+/**********************************************************
+Description: get PS sample latency and jitter statistics
+Parameters:  stats:Variables for storing the statistics(unit:us)
+Return:      none
+Others:      Interval statistics need at least 2 samples; they are 0
+             until then. Compare intervalMean with getPSPeriod().
+**********************************************************/
+void BMS33M332::getTimingStats(BMS33M332_TimingStats &stats)
+{
+      BMS33M332BusGuard guard(_bus);   //counters are updated under the bus lock
+      stats.count        = _sampleCnt;
+      stats.latencyMin   = _latencyMin;
+      stats.latencyMax   = _latencyMax;
+      stats.latencyMean  = (_sampleCnt > 0) ? (uint32_t)(_latencySum / _sampleCnt) : 0;
+      stats.intervalMin  = _intervalMin;
+      stats.intervalMax  = _intervalMax;
+      stats.intervalMean = (_sampleCnt > 1) ? (uint32_t)(_intervalSum / (_sampleCnt - 1)) : 0;
+      stats.jitter       = _intervalMax - _intervalMin;
+}
+/**********************************************************
+Description: reset PS sample latency and jitter statistics
+Parameters:  none
+Return:      none
+Others:      none
+**********************************************************/
+void BMS33M332::resetTimingStats()
+{
+      BMS33M332BusGuard guard(_bus);
+      _sampleCnt   = 0;
+      _latencyMin  = 0;
+      _latencyMax  = 0;
+      _latencySum  = 0;
+      _intervalMin = 0;
+      _intervalMax = 0;
+      _intervalSum = 0;
+}
+/**********************************************************
+Description: capture a burst of PS(and ALS) samples
+Parameters:  ps    :caller array of n PS samples
+             als   :caller array of n ALS samples, or NULL for PS only
+             n     :number of samples to capture
+             period:sample period(unit:us), 0 = getPSPeriod() of the
+                    burst configuration
+Return:      Achieved average sample period(unit:us), 0 if n < 2 or a
+             sample read failed(that entry holds 0)
+Others:      The first sample is taken one old getPSPeriod() plus one
+             burst period after reconfiguring, so no entry holds data
+             converted with the previous setting. For the burst IT_PS
+             is set to 96us, EN_WAIT and EN_INTELLI_WAIT are cleared
+             and, if als is NULL, EN_ALS is cleared; STATE_REG and
+             PSCTRL_REG are restored afterwards. With als the ALS
+             integration time still bounds the period. Samples are
+             read straight into ps/als without the bus settle time
+             after readReg(); the TwoWire bus still waits 1 ms between
+             address write and read, so there the rate is at most
+             about 1 kHz. The bus lock is released between samples, so
+             other devices on the bus can be served during the burst.
+**********************************************************/
+uint32_t BMS33M332::captureBurst(uint16_t *ps,uint16_t *als,size_t n,uint32_t period)
+{
+      uint8_t state = 0, psCtrl = 0, burstState = 0;
+      uint8_t rBuf[4];
+      uint8_t rLen = (als != NULL) ? 4 : 2;
+      uint32_t first = 0, next = 0, now = 0, oldPeriod = 0;
+      bool failed = false;
+      if(n == 0)
+      {
+            return 0;
+      }
+      /*save and set the fastest PS configuration*/
+      {
+            BMS33M332BusGuard guard(_bus);
+            oldPeriod = getPSPeriod();
+            state  = readReg(STATE_REG);
+            psCtrl = readReg(PSCTRL_REG);
+            burstState = state & ~((1<<EN_WAIT) | (1<<EN_INTELLI_WAIT));
+            if(als == NULL)
+            {
+                  burstState &= ~(1<<EN_ALS);
+            }
+            writeReg(PSCTRL_REG, (psCtrl & 0xF0) | IT_PS_96US);
+            writeReg(STATE_REG, burstState);
+            if(period == 0)
+            {
+                  period = getPSPeriod();
+            }
+      }
+      /*paced read straight into the caller arrays*/
+      /*the cycle already running still converts with the old setting*/
+      next = micros() + oldPeriod + period;
+      for(size_t i = 0; i < n; i++)
+      {
+            while((int32_t)(micros() - next) < 0);
+            now = micros();
+            if(i == 0)
+            {
+                  first = now;
+            }
+            next += period;
+            if(readBytes(DATA1_PS_REG, rBuf, rLen) == false)
+            {
+                  ps[i] = 0;
+                  if(als != NULL) als[i] = 0;
+                  failed = true;
+                  continue;
+            }
+            ps[i] = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
+            if(als != NULL)
+            {
+                  als[i] = ((uint16_t)rBuf[2]<<8 | rBuf[3]);
+            }
+      }
+      /*restore the previous configuration*/
+      {
+            BMS33M332BusGuard guard(_bus);
+            writeReg(PSCTRL_REG, psCtrl);
+            writeReg(STATE_REG, state);
+      }
+      return (n > 1 && !failed) ? (now - first) / (n - 1) : 0;
+}
+/**********************************************************
 Description:Get product ID
 Parameters: none
 Return:     Product ID(1 byte)         
@@ -94,8 +321,9 @@ Others: PDT_ID = Product ID =0x52 to indicate the product information
 uint8_t BMS33M332::getPDTID()
 {
      uint8_t idVlaue = 0;
-     readReg(PDT_ID_REG,dataBuff,1);
-     idVlaue = dataBuff[0];
+     uint8_t rBuf[1] = {0};
+     readReg(PDT_ID_REG,rBuf,1);
+     idVlaue = rBuf[0];
      return idVlaue;
 }
 /**********************************************************
@@ -112,11 +340,10 @@ void BMS33M332::setINT(uint16_t thdh,uint16_t thdl,bool isEnable)
 {  
       if(isEnable == true)
       {
+            uint8_t thd[4] = {(uint8_t)(thdh>>8), (uint8_t)thdh,    //THDH_PS
+                              (uint8_t)(thdl>>8), (uint8_t)thdl};   //THDL_PS
             writeReg(INTCTRL1_REG, 0x03);//set EN_PS_INT,PS_NF_MODE    
-            writeReg(THDH1_PS_REG, thdh>>8);
-            writeReg(THDH2_PS_REG, thdh);   //THDH_PS 
-            writeReg(THDL1_PS_REG, thdl>>8);
-            writeReg(THDL2_PS_REG, thdl);   //THDL_PS 
+            writeReg(THDH1_PS_REG, thd, 4);
       }
       if(isEnable == false)
       {
@@ -147,8 +374,9 @@ Others:      Object near/far status. Default status = 1, object in far state.
 uint8_t BMS33M332::getPositionStatus()
 {
       uint8_t status = 0;
-      readReg(FLAG_REG,dataBuff,1);
-      status = dataBuff[0] & 0x01; //bit 0
+      uint8_t rBuf[1] = {0};
+      readReg(FLAG_REG,rBuf,1);
+      status = rBuf[0] & 0x01; //bit 0
       return status;
 }
 /**********************************************************
@@ -172,7 +400,30 @@ void BMS33M332::writeReg(uint8_t addr, uint8_t data)
 {
     uint8_t sendBuf[2]={addr,data};
     writeBytes(sendBuf,2);
-    delay(1);
+    _bus->settle();
+}
+/**********************************************************
+Description: write consecutive Registers
+Parameters:  addr :First register to be written
+             wBuf:Values to be written
+             wLen:the byte of the data(max BMS33M332_MAX_BURST)
+Return:      none    
+Others:      One IIC transfer, the register address auto increments
+**********************************************************/
+void BMS33M332::writeReg(uint8_t addr, const uint8_t wBuf[], uint8_t wLen)
+{
+    uint8_t sendBuf[1 + BMS33M332_MAX_BURST];
+    if(wLen > BMS33M332_MAX_BURST)
+    {
+        wLen = BMS33M332_MAX_BURST;
+    }
+    sendBuf[0] = addr;
+    for(uint8_t i = 0; i < wLen; i++)
+    {
+        sendBuf[1 + i] = wBuf[i];
+    }
+    writeBytes(sendBuf,1 + wLen);
+    _bus->settle();
 }
 /**********************************************************
 Description: read Register data
@@ -183,13 +434,10 @@ Others:      user can use this function to read any register
 **********************************************************/
 uint8_t BMS33M332::readReg(uint8_t addr)
 {
-    clearBuf();
-    uint8_t sendBuf[1] = {addr};
-    writeBytes(sendBuf,1);
-    delay(1);
-    readBytes(dataBuff,1);
-    delay(1);
-    return dataBuff[0];
+    uint8_t rBuf[1] = {0};
+    readBytes(addr,rBuf,1);
+    _bus->settle();
+    return rBuf[0];
 }
 /**********************************************************
 Description: read Register to get Data
@@ -201,12 +449,8 @@ Others:      none
 **********************************************************/
 void BMS33M332::readReg(uint8_t addr, uint8_t rBuf[], uint8_t rLen)
 {
-    clearBuf();
-    uint8_t sendBuf[1] = {addr};
-    writeBytes(sendBuf,1);
-    delay(1);
-    readBytes(rBuf,rLen);
-    delay(1);
+    readBytes(addr,rBuf,rLen);
+    _bus->settle();
 }
 /**********************************************************
 Description: get LED constant current
@@ -224,8 +468,9 @@ Others:       none
 uint8_t BMS33M332::getLEDcurrent()
 {      
        uint8_t currentValue = 0;
-       readReg(LEDCTRL_REG,dataBuff,1);
-       currentValue = dataBuff[0] >> 5;
+       uint8_t rBuf[1] = {0};
+       readReg(LEDCTRL_REG,rBuf,1);
+       currentValue = rBuf[0] >> 5;
        return currentValue;
 }
 /**********************************************************
@@ -237,8 +482,9 @@ Others:      none
 uint8_t BMS33M332::getMeasureIntervalTime()
 {
     uint8_t time = 0;
-    readReg(WAIT_REG,dataBuff,1);
-    time = dataBuff[0];
+    uint8_t rBuf[1] = {0};
+    readReg(WAIT_REG,rBuf,1);
+    time = rBuf[0];
     return time;
 }
 /**********************************************************
@@ -250,8 +496,9 @@ Others:      none
 uint16_t BMS33M332::getPSHighThreshold()
 {
       uint16_t thdh = 0;
-      readReg(THDH1_PS_REG,dataBuff,2);
-      thdh = ((uint16_t)dataBuff[0]<<8 | dataBuff[1]);
+      uint8_t rBuf[2] = {0};
+      readReg(THDH1_PS_REG,rBuf,2);
+      thdh = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
       return thdh;
       
 }
@@ -264,8 +511,9 @@ Others:      none
 uint16_t BMS33M332::getPSLowThreshold()
 {
       uint16_t thdl = 0;
-      readReg(THDL1_PS_REG,dataBuff,2);
-      thdl = ((uint16_t)dataBuff[0]<<8 | dataBuff[1]);
+      uint8_t rBuf[2] = {0};
+      readReg(THDL1_PS_REG,rBuf,2);
+      thdl = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
       return thdl;   
 }
 /**********************************************************
@@ -277,8 +525,9 @@ Others:      none
 uint16_t BMS33M332::getALSHighThreshold()
 {
       uint16_t thdh = 0;
-      readReg(THDH1_ALS_REG,dataBuff,2);
-      thdh = ((uint16_t)dataBuff[0]<<8 | dataBuff[1]);
+      uint8_t rBuf[2] = {0};
+      readReg(THDH1_ALS_REG,rBuf,2);
+      thdh = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
       return thdh;
 }
 /**********************************************************
@@ -290,8 +539,9 @@ Others:      none
 uint16_t BMS33M332::getALSLowThreshold()
 {
       uint16_t thdl = 0;
-      readReg(THDL1_ALS_REG,dataBuff,2);
-      thdl = ((uint16_t)dataBuff[0]<<8 | dataBuff[1]);
+      uint8_t rBuf[2] = {0};
+      readReg(THDL1_ALS_REG,rBuf,2);
+      thdl = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
       return thdl;   
 }
 
@@ -338,8 +588,8 @@ Others:      none
 **********************************************************/
 void BMS33M332::setPSHighThreshold(uint16_t thdh)
 {
-      writeReg(THDH1_PS_REG, thdh>>8);
-      writeReg(THDH2_PS_REG, thdh);
+      uint8_t thd[2] = {(uint8_t)(thdh>>8), (uint8_t)thdh};
+      writeReg(THDH1_PS_REG, thd, 2);
 }
 
 /**********************************************************
@@ -350,8 +600,8 @@ Others:      none
 **********************************************************/
 void BMS33M332::setPSLowThreshold(uint16_t thdl)
 {
-      writeReg(THDL1_PS_REG, thdl>>8);
-      writeReg(THDL2_PS_REG, thdl);
+      uint8_t thd[2] = {(uint8_t)(thdl>>8), (uint8_t)thdl};
+      writeReg(THDL1_PS_REG, thd, 2);
 }
 /**********************************************************
 Description: setALSHighThreshold
@@ -361,8 +611,8 @@ Others:      none
 **********************************************************/
 void BMS33M332::setALSHighThreshold(uint16_t thdh)
 {
-      writeReg(THDH1_ALS_REG, thdh>>8);
-      writeReg(THDH2_ALS_REG, thdh);
+      uint8_t thd[2] = {(uint8_t)(thdh>>8), (uint8_t)thdh};
+      writeReg(THDH1_ALS_REG, thd, 2);
 }
 /**********************************************************
 Description: setALSLowThreshold
@@ -372,11 +622,55 @@ Others:      none
 **********************************************************/
 void BMS33M332::setALSLowThreshold(uint16_t thdl)
 {
-      writeReg(THDL1_ALS_REG, thdl>>8);
-      writeReg(THDL2_ALS_REG, thdl);
+      uint8_t thd[2] = {(uint8_t)(thdl>>8), (uint8_t)thdl};
+      writeReg(THDL1_ALS_REG, thd, 2);
 }
 
 
+/**********************************************************
+Description: get IIC bus usage of this driver
+Parameters:  transactions:Variables for storing the number of IIC transfers
+             bytes       :Variables for storing the bytes on the bus
+Return:      none
+Others:      A register write is one transfer and a register read two
+             (address write + data read, combined into one bus call
+             where the bus supports it); bytes count the address byte
+             plus the data bytes of each transfer.
+**********************************************************/
+void BMS33M332::getBusStats(uint32_t &transactions,uint32_t &bytes)
+{
+      BMS33M332BusGuard guard(_bus);   //counters are updated under the bus lock
+      transactions = _busTransactions;
+      bytes = _busBytes;
+}
+/**********************************************************
+Description: set the lock serializing access to the IIC bus
+Parameters:  lock:BMS33M332Lock shared by every task/driver using this 
+                  IIC port, NULL = no locking(default)
+Return:      none
+Others:      Each transfer, read-modify-write and data ready check/clear
+             holds the lock, so the lock must be recursive(e.g.
+             BMS33M332StdLock or a FreeRTOS recursive mutex). Other
+             drivers on the bus wrap their transfers in
+             BMS33M332BusGuard guard(lock), which skips a NULL lock.
+             Do not access the bus from an ISR; signal a task instead.
+**********************************************************/
+void BMS33M332::setBusLock(BMS33M332Lock *lock)
+{
+      _bus->setLock(lock);
+}
+/**********************************************************
+Description: reset IIC bus usage counters
+Parameters:  none
+Return:      none
+Others:      none
+**********************************************************/
+void BMS33M332::resetBusStats()
+{
+      BMS33M332BusGuard guard(_bus);
+      _busTransactions = 0;
+      _busBytes = 0;
+}
 /**********************************************************
 Description: read Clear Channe lValue
 Parameters:  none
@@ -386,8 +680,9 @@ Others:      none
 uint16_t BMS33M332::readClearChannelValue()
 {
       uint16_t clearChannelValue = 0;
-      readReg(DATA1_C_REG,dataBuff,2);
-      clearChannelValue = ((uint16_t)dataBuff[0]<<8 | dataBuff[1]);
+      uint8_t rBuf[2] = {0};
+      readReg(DATA1_C_REG,rBuf,2);
+      clearChannelValue = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
       return clearChannelValue;
 }
 /**********************************************************
@@ -565,26 +860,101 @@ Others:      none
 uint16_t BMS33M332::getPSOffset()
 {
         uint16_t offsetValue = 0;
-        readReg(DATA1_PS_OFFSET_REG,dataBuff,2);
-        offsetValue = ((uint16_t)dataBuff[0]<<8 | dataBuff[1]);
+        uint8_t rBuf[2] = {0};
+        readReg(DATA1_PS_OFFSET_REG,rBuf,2);
+        offsetValue = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
         return offsetValue; 
 }
 /**********************************************************
+Description: read the data registers whose DR flag is set
+Parameters:  mask    :FLG_PS_DR and/or FLG_ALS_DR channels to check
+             psValue :Variables for storing PS data(unchanged if not ready)
+             alsValue:Variables for storing ALS data(unchanged if not ready)
+Return:      Data ready mask of the values updated
+Others:      FLAG_REG bits are write-0-to-clear, so only the consumed DR
+             bits are written as 0; flags set meanwhile are kept. They
+             are cleared before the data read: a conversion completing
+             during the read raises DR again and is returned next call
+             (at worst twice) instead of being lost.
+**********************************************************/
+uint8_t BMS33M332::readDataIfReady(uint8_t mask,uint16_t &psValue,uint16_t &alsValue)
+{
+      uint8_t flag = 0;
+      uint8_t ready = 0;
+      uint32_t readyTime = 0;
+      BMS33M332BusGuard guard(_bus);
+      readyTime = micros();   //latency includes the FLAG_REG read and settle
+      flag = readReg(FLAG_REG);
+      ready = flag & mask;
+      if(ready != 0)
+      {
+            writeReg(FLAG_REG, (uint8_t)~ready);//Clear FLG_PS_DR/FLG_ALS_DR only
+      }
+      if(ready == (FLG_PS_DR | FLG_ALS_DR))
+      {
+            uint8_t rBuf[4] = {0};
+            readReg(DATA1_PS_REG,rBuf,4);
+            psValue  = ((uint16_t)rBuf[0]<<8 | rBuf[1]);
+            alsValue = ((uint16_t)rBuf[2]<<8 | rBuf[3]);
+      }
+      else if(ready == FLG_PS_DR)
+      {
+            psValue = readRawProximity();
+      }
+      else if(ready == FLG_ALS_DR)
+      {
+            alsValue = readRawAmbient();
+      }
+      if(ready & FLG_PS_DR)
+      {
+            recordPSSample(readyTime, micros());
+      }
+      return ready;
+}
+/**********************************************************
+Description: record the timestamps of a PS sample
+Parameters:  readyTime:micros() at the start of the FLAG_REG read that
+                       found FLG_PS_DR
+             doneTime :micros() when the PS data read completed
+Return:      none
+Others:      Unsigned subtraction keeps the deltas valid across
+             micros() overflow
+**********************************************************/
+void BMS33M332::recordPSSample(uint32_t readyTime,uint32_t doneTime)
+{
+      uint32_t latency = doneTime - readyTime;
+      uint32_t interval = readyTime - _psReadyTime;
+      if(_sampleCnt == 0)
+      {
+            _latencyMin = latency;
+            _latencyMax = latency;
+      }
+      else
+      {
+            if(latency < _latencyMin) _latencyMin = latency;
+            if(latency > _latencyMax) _latencyMax = latency;
+            if(_sampleCnt == 1 || interval < _intervalMin) _intervalMin = interval;
+            if(_sampleCnt == 1 || interval > _intervalMax) _intervalMax = interval;
+            _intervalSum += interval;
+      }
+      _latencySum += latency;
+      _sampleCnt++;
+      _psReadyTime = readyTime;
+      _psDoneTime  = doneTime;
+}
+/**********************************************************
 Description: writeBytes
 Parameters:  wbuf[]:Variables for storing Data to be sent
              wlen:Length of data sent  
-Return:   
+Return:      true:ACK  false:NACK or bus error
 Others:
 **********************************************************/
-void BMS33M332::writeBytes(uint8_t wbuf[], uint8_t wlen)
+bool BMS33M332::writeBytes(uint8_t wbuf[], uint8_t wlen)
 {
-    while(_wire->available() > 0)
-    {
-      _wire->read();
-    }
-    _wire->beginTransmission(_i2caddr); //IIC start with 7bit addr
-    _wire->write(wbuf, wlen);
-    _wire->endTransmission();
+    BMS33M332BusGuard guard(_bus);
+    _busTransactions++;
+    _busBytes += 1 + wlen;
+    return _bus->write(_i2caddr, wbuf, wlen);
 }
 /**********************************************************
 Description: write a bit data
@@ -595,40 +965,26 @@ Others:      none
 **********************************************************/
 void BMS33M332::writeRegBit(uint8_t addr,uint8_t bitNum, uint8_t bitValue)
 {
+      BMS33M332BusGuard guard(_bus);
       uint8_t data;
-      readReg(addr,dataBuff,1);
-      data = dataBuff[0];
+      uint8_t rBuf[1] = {0};
+      readReg(addr,rBuf,1);
+      data = rBuf[0];
       data = (bitValue != 0)? (data|(1<<bitNum)) : (data & ~(1 << bitNum));
       writeReg(addr, data);
 }
 /**********************************************************
 Description: readBytes
-Parameters:  rbuf[]:Variables for storing Data to be obtained
+Parameters:  addr:Register to be read
+             rbuf[]:Variables for storing Data to be obtained
              rlen:Length of data to be obtained
-Return:   
+Return:      true:rlen bytes received  false:rbuf unchanged
 Others:
 **********************************************************/
-void BMS33M332::readBytes(uint8_t rbuf[], uint8_t rlen)
+bool BMS33M332::readBytes(uint8_t addr, uint8_t rbuf[], uint8_t rlen)
 {
-    _wire->requestFrom(_i2caddr, rlen);
-    if(_wire->available()==rlen)
-    {
-      for(uint8_t i = 0; i < rlen; i++)
-      {
-        rbuf[i] = _wire->read();
-      }
-    }
-}
-/**********************************************************
-Description: clear Buff
-Parameters:  none            
-Return:      none    
-Others:      none
-**********************************************************/
-void BMS33M332::clearBuf()
-{
-      for(int a = 0; a < 4; a++)
-      {
-        dataBuff[a] = 0;
-      } 
-}
+    BMS33M332BusGuard guard(_bus);
+    _busTransactions += 2;
+    _busBytes += 2 + 1 + rlen;
+    return _bus->writeRead(_i2caddr, &addr, 1, rbuf, rlen);
+}
\ No newline at end of file
@@ -9,12 +9,13 @@ V1.0.1   -- initial version；2021-06-25；Arduino IDE :v1.8.15
 #ifndef _BMS33M332_H_
 #define _BMS33M332_H_
 
-#include <Wire.h>
-#include <Arduino.h>
+#include "BMS33M332Bus.h"
 
 #define OK                0x01
 #define ERROR             0x02
+#define BMS33M332_LIB_VERSION       "1.0.1"  //same as library.properties
 const uint8_t BMS33M332_IICADDR = 0x47;
+#define BMS33M332_MAX_BURST         8        //max bytes of a register burst write
 
 /*State Register*/
 #define EN_PS             0x00
@@ -109,16 +110,44 @@ const uint8_t BMS33M332_IICADDR = 0x47;
 #define     INTELLI_WAIT_PS_REG       0x4F
 #define     SOFT_RESET_REG            0x80
 #define     INTCTRL2_REG              0xA5
+/*FLAG_REG data ready bits*/
+#define FLG_PS_DR         0x40     //bit6
+#define FLG_ALS_DR        0x80     //bit7
+
+/*PS sample timing statistics(unit:us)*/
+typedef struct
+{
+   uint32_t count;          //PS samples recorded
+   uint32_t latencyMin;     //FLAG_REG read started -> data read completed
+   uint32_t latencyMean;
+   uint32_t latencyMax;
+   uint32_t intervalMin;    //between successive data ready
+   uint32_t intervalMean;
+   uint32_t intervalMax;
+   uint32_t jitter;         //intervalMax - intervalMin
+} BMS33M332_TimingStats;
 
 class BMS33M332
 {
    public:
+#if defined(ARDUINO)
    BMS33M332(uint8_t intPin,TwoWire *theWire = &Wire);
+#endif
+   BMS33M332(uint8_t intPin,BMS33M332Bus *bus);
    void begin(uint8_t addr = BMS33M332_IICADDR);
 
    uint16_t readRawProximity();
    uint16_t readRawAmbient();
    float readAmbient();
+   bool readRawProximityIfReady(uint16_t &psValue);
+   bool readRawAmbientIfReady(uint16_t &alsValue);
+   uint8_t readRawIfReady(uint16_t &psValue,uint16_t &alsValue);
+
+   uint32_t getPSPeriod();
+   void getLastPSSampleTime(uint32_t &readyTime,uint32_t &doneTime);
+   void getTimingStats(BMS33M332_TimingStats &stats);
+   void resetTimingStats();
+   uint32_t captureBurst(uint16_t *ps,uint16_t *als,size_t n,uint32_t period = 0);
    uint8_t getPDTID();
    void setINT(uint16_t thdh,uint16_t thdl,bool isEnable = true);
    uint8_t getINT();
@@ -126,6 +155,7 @@ class BMS33M332
    void reset();
 
    void writeReg(uint8_t addr, uint8_t data);
+   void writeReg(uint8_t addr, const uint8_t wBuf[], uint8_t wLen);
    uint8_t readReg(uint8_t addr);
    void readReg(uint8_t addr, uint8_t rBuf[], uint8_t rLen);
    
@@ -142,33 +172,52 @@ class BMS33M332
    void setPSLowThreshold(uint16_t thdl);
    void setALSHighThreshold(uint16_t thdh);
    void setALSLowThreshold(uint16_t thdl);
+   void setPSIntegrationTime(uint8_t time);
+   void setPSGain(uint8_t gain);
+   void setALSIntegrationTime(uint8_t time);
+   void setALSGain(uint8_t gain);
+
+   void getBusStats(uint32_t &transactions,uint32_t &bytes);
+   void setBusLock(BMS33M332Lock *lock);
+   void resetBusStats();
    
    private:
    uint16_t readClearChannelValue();
-   void setALSIntegrationTime(uint8_t time);
-   void setPSIntegrationTime(uint8_t time);
    void setALSClearChannelGain(uint8_t gain);
-   void setPSGain(uint8_t gain);
-   void setALSGain(uint8_t gain);
    void setPSIntelligentPersistence(uint8_t time,bool isEnable = true);
    void setALSIntelligentPersistence(uint8_t time,bool isEnable = true);
    void setPSOffset(uint16_t offset);
    uint16_t getPSOffset();
+   uint8_t readDataIfReady(uint8_t mask,uint16_t &psValue,uint16_t &alsValue);
+   void recordPSSample(uint32_t readyTime,uint32_t doneTime);
 
-   void writeBytes(uint8_t wbuf[], uint8_t wlen);
+   bool writeBytes(uint8_t wbuf[], uint8_t wlen);
    void writeRegBit(uint8_t addr,uint8_t bitNum, uint8_t bitValue);
-   void readBytes(uint8_t rbuf[], uint8_t rlen);
+   bool readBytes(uint8_t addr, uint8_t rbuf[], uint8_t rlen);
 
-   void clearBuf();
    uint8_t _i2caddr;
-   uint8_t dataBuff[4];   //Store public data
-   int dataCnt = 0;
    uint8_t _intPin;
    /*LUX/LSB Related parameters*/
    uint8_t _alsIt   = 4;
    uint8_t _alsGain = 1;
    float   _alsLsb  = 0.2051;//Gain*1 IT*4
-   TwoWire *_wire;
+   /*PS sample timing(unit:us)*/
+   uint32_t _psReadyTime = 0;
+   uint32_t _psDoneTime  = 0;
+   uint32_t _sampleCnt   = 0;
+   uint32_t _latencyMin  = 0;
+   uint32_t _latencyMax  = 0;
+   uint64_t _latencySum  = 0;
+   uint32_t _intervalMin = 0;
+   uint32_t _intervalMax = 0;
+   uint64_t _intervalSum = 0;
+   /*IIC bus usage*/
+   uint32_t _busTransactions = 0;
+   uint32_t _busBytes        = 0;
+   BMS33M332Bus *_bus;
+#if defined(ARDUINO)
+   BMS33M332WireBus _wireBus;
+#endif
 };
 
 /*Clear FLAG Register*/
@@ -0,0 +1,86 @@
+/*****************************************************************
+File:        BMS33M332Bus.cpp
+Author:      BESTMODULES
+Description: Arduino TwoWire implementation of BMS33M332Bus
+******************************************************************/
+#include "BMS33M332Bus.h"
+
+#if defined(ARDUINO)
+/**********************************************************
+Description: Constructor
+Parameters:  theWire : Wire object if your board has more than one I2C interface
+Return:      none
+Others:      none
+**********************************************************/
+BMS33M332WireBus::BMS33M332WireBus(TwoWire *theWire)
+{
+     _wire = theWire;
+}
+/**********************************************************
+Description: IIC Initial
+Parameters:  none
+Return:      none
+Others:      none
+**********************************************************/
+void BMS33M332WireBus::begin()
+{
+     _wire->begin();
+}
+/**********************************************************
+Description: write data to the device
+Parameters:  addr:7bit IIC address
+             wbuf[]:Variables for storing Data to be sent
+             wlen:Length of data sent
+Return:      true:ACK  false:NACK or bus error
+Others:      none
+**********************************************************/
+bool BMS33M332WireBus::write(uint8_t addr, const uint8_t wbuf[], uint8_t wlen)
+{
+    while(_wire->available() > 0)
+    {
+      _wire->read();
+    }
+    _wire->beginTransmission(addr); //IIC start with 7bit addr
+    _wire->write(wbuf, wlen);
+    return _wire->endTransmission() == 0;
+}
+/**********************************************************
+Description: write data then read from the device
+Parameters:  addr:7bit IIC address
+             wbuf[]:Variables for storing Data to be sent
+             wlen:Length of data sent
+             rbuf[]:Variables for storing Data to be obtained
+             rlen:Length of data to be obtained
+Return:      true:rlen bytes received  false:rbuf unchanged
+Others:      Stop + 1 ms between write and read, as in V1.0.1
+**********************************************************/
+bool BMS33M332WireBus::writeRead(uint8_t addr, const uint8_t wbuf[], uint8_t wlen,
+                                 uint8_t rbuf[], uint8_t rlen)
+{
+    if(write(addr, wbuf, wlen) == false)
+    {
+      return false;
+    }
+    delay(1);
+    _wire->requestFrom(addr, rlen);
+    if(_wire->available() != rlen)
+    {
+      return false;
+    }
+    for(uint8_t i = 0; i < rlen; i++)
+    {
+      rbuf[i] = _wire->read();
+    }
+    return true;
+}
+/**********************************************************
+Description: settle time after a register access
+Parameters:  none
+Return:      none
+Others:      1 ms, as the module has always used with TwoWire
+**********************************************************/
+void BMS33M332WireBus::settle()
+{
+    delay(1);
+}
+#endif
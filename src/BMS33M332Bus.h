@@ -0,0 +1,101 @@
+/*****************************************************************
+File:             BMS33M332Bus.h
+Author:           BESTMODULES
+Description:      IIC bus interface used by the BMS33M332 class, and the
+                  Arduino TwoWire implementation
+******************************************************************/
+
+#ifndef _BMS33M332BUS_H_
+#define _BMS33M332BUS_H_
+
+#if defined(ARDUINO)
+#include <Wire.h>
+#include <Arduino.h>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+#endif
+
+/*Bus lock hook, must be recursive(lock() again by the holder succeeds)*/
+class BMS33M332Lock
+{
+   public:
+   virtual ~BMS33M332Lock() {}
+   virtual void lock() = 0;
+   virtual void unlock() = 0;
+};
+
+#if !defined(ARDUINO)
+class BMS33M332StdLock : public BMS33M332Lock
+{
+   public:
+   void lock()   { _mutex.lock(); }
+   void unlock() { _mutex.unlock(); }
+
+   private:
+   std::recursive_mutex _mutex;
+};
+#endif
+
+class BMS33M332Bus
+{
+   public:
+   virtual ~BMS33M332Bus() {}
+   /*Share one lock between every bus object and driver using the same IIC port*/
+   void setLock(BMS33M332Lock *lock) { _lock = lock; }
+   BMS33M332Lock *getLock() { return _lock; }
+   virtual void begin() {}
+   /*Send wbuf to the device, true on ACK*/
+   virtual bool write(uint8_t addr, const uint8_t wbuf[], uint8_t wlen) = 0;
+   /*Send wbuf, then read rlen bytes into rbuf(rbuf unchanged on failure)*/
+   virtual bool writeRead(uint8_t addr, const uint8_t wbuf[], uint8_t wlen,
+                          uint8_t rbuf[], uint8_t rlen) = 0;
+   /*Pause after a register access, if the bus needs one*/
+   virtual void settle() {}
+
+   private:
+   BMS33M332Lock *_lock = NULL;
+};
+
+/*Holds the bus lock(if any) for the lifetime of the object*/
+class BMS33M332BusGuard
+{
+   public:
+   BMS33M332BusGuard(BMS33M332Bus *bus) : _lock(bus->getLock())
+   {
+      if(_lock != NULL) _lock->lock();
+   }
+   /*For other drivers sharing the IIC port, NULL = no locking*/
+   BMS33M332BusGuard(BMS33M332Lock *lock) : _lock(lock)
+   {
+      if(_lock != NULL) _lock->lock();
+   }
+   ~BMS33M332BusGuard()
+   {
+      if(_lock != NULL) _lock->unlock();
+   }
+
+   private:
+   BMS33M332BusGuard(const BMS33M332BusGuard &);
+   BMS33M332BusGuard &operator=(const BMS33M332BusGuard &);
+   BMS33M332Lock *_lock;
+};
+
+#if defined(ARDUINO)
+class BMS33M332WireBus : public BMS33M332Bus
+{
+   public:
+   BMS33M332WireBus(TwoWire *theWire = &Wire);
+   void begin();
+   bool write(uint8_t addr, const uint8_t wbuf[], uint8_t wlen);
+   bool writeRead(uint8_t addr, const uint8_t wbuf[], uint8_t wlen,
+                  uint8_t rbuf[], uint8_t rlen);
+   void settle();
+
+   private:
+   TwoWire *_wire;
+};
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+/*****************************************************************
+File:             BMS33M332Frame.h
+Author:           BESTMODULES
+Description:      Binary telemetry frame format shared by the 
+                  BMS33M332Stream encoder and host-side decoders.
+                  Only depends on <stdint.h> so it also builds on a PC.
+
+Frame:   SYNC0 SYNC1 LEN PAYLOAD[LEN] CRC8
+         CRC8(poly 0x07, init 0x00) covers LEN and PAYLOAD
+Payload: HDR   bit7 = key record, bit6~0 = sequence number
+         TIME  varint, key: absolute time(us), else delta time(us)
+         FLAGS FLAG_REG/data ready bits of the sample
+         PS    varint, key: absolute value, else zigzag delta
+         ALS   varint, key: absolute value, else zigzag delta
+******************************************************************/
+
+#ifndef _BMS33M332FRAME_H_
+#define _BMS33M332FRAME_H_
+
+#include <stdint.h>
+
+#define BMS33M332_FRAME_SYNC0       0xB3
+#define BMS33M332_FRAME_SYNC1       0x32
+#define BMS33M332_FRAME_KEY         0x80     //HDR bit7
+#define BMS33M332_FRAME_SEQ_MASK    0x7F
+#define BMS33M332_FRAME_MAX_PAYLOAD 13       //1+5+1+3+3
+#define BMS33M332_FRAME_MAX_LEN     (3 + BMS33M332_FRAME_MAX_PAYLOAD + 1)
+
+/*CRC-8, poly x^8+x^2+x+1*/
+static inline uint8_t bms33m332Crc8(uint8_t crc, uint8_t data)
+{
+   crc ^= data;
+   for(uint8_t i = 0; i < 8; i++)
+   {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+   }
+   return crc;
+}
+
+/*Map a signed delta to unsigned so small deltas stay small*/
+static inline uint32_t bms33m332ZigZag(int32_t value)
+{
+   return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t bms33m332UnZigZag(uint32_t value)
+{
+   return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/*LEB128 varint, returns the number of bytes written(1~5)*/
+static inline uint8_t bms33m332PutVarint(uint8_t buf[], uint32_t value)
+{
+   uint8_t len = 0;
+   while(value >= 0x80)
+   {
+      buf[len++] = (uint8_t)(value | 0x80);
+      value >>= 7;
+   }
+   buf[len++] = (uint8_t)value;
+   return len;
+}
+
+/*Returns the number of bytes read, 0 if the varint overruns len*/
+static inline uint8_t bms33m332GetVarint(const uint8_t buf[], uint8_t len, uint32_t *value)
+{
+   uint32_t result = 0;
+   for(uint8_t i = 0; i < len && i < 5; i++)
+   {
+      result |= (uint32_t)(buf[i] & 0x7F) << (7 * i);
+      if((buf[i] & 0x80) == 0)
+      {
+         *value = result;
+         return i + 1;
+      }
+   }
+   return 0;
+}
+
+#endif
@@ -0,0 +1,203 @@
+/*****************************************************************
+File:        BMS33M332LinuxBus.cpp
+Author:      BESTMODULES
+Description: Linux i2c-dev implementation of BMS33M332Bus. Every 
+             register access is a single ioctl without sleeping:
+             I2C_RDWR(write + repeated start read) on IIC adapters,
+             I2C_SMBUS i2c block transfers on SMBus-only adapters.
+             Test without the module: modprobe i2c-stub chip_addr=0x47
+******************************************************************/
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include "BMS33M332LinuxBus.h"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+/**********************************************************
+Description: Constructor
+Parameters:  device :i2c-dev node of the adapter, e.g. "/dev/i2c-1"
+Return:      none
+Others:      The device is opened by begin()
+**********************************************************/
+BMS33M332LinuxBus::BMS33M332LinuxBus(const char *device)
+{
+     _device = device;
+}
+/**********************************************************
+Description: Destructor
+Parameters:  none
+Return:      none
+Others:      none
+**********************************************************/
+BMS33M332LinuxBus::~BMS33M332LinuxBus()
+{
+     if(_fd >= 0)
+     {
+        close(_fd);
+     }
+}
+/**********************************************************
+Description: open the adapter
+Parameters:  none
+Return:      none
+Others:      Check isOpen() afterwards
+**********************************************************/
+void BMS33M332LinuxBus::begin()
+{
+     unsigned long funcs = 0;
+     if(_fd >= 0)
+     {
+        return;
+     }
+     _fd = open(_device, O_RDWR);
+     if(_fd < 0)
+     {
+        return;
+     }
+     if(ioctl(_fd, I2C_FUNCS, &funcs) == 0)
+     {
+        _smbusOnly = (funcs & I2C_FUNC_I2C) == 0;
+     }
+}
+/**********************************************************
+Description: adapter status
+Parameters:  none
+Return:      true:the i2c-dev node is open
+Others:      none
+**********************************************************/
+bool BMS33M332LinuxBus::isOpen()
+{
+     return _fd >= 0;
+}
+/**********************************************************
+Description: write data to the device
+Parameters:  addr:7bit IIC address
+             wbuf[]:Variables for storing Data to be sent
+                    (wbuf[0] is the register address)
+             wlen:Length of data sent
+Return:      true:ACK  false:NACK or bus error
+Others:      A register burst(wlen > 2) is still one transfer
+**********************************************************/
+bool BMS33M332LinuxBus::write(uint8_t addr, const uint8_t wbuf[], uint8_t wlen)
+{
+     if(_fd < 0 || wlen == 0)
+     {
+        return false;
+     }
+     if(_smbusOnly)
+     {
+        struct i2c_smbus_ioctl_data args;
+        union i2c_smbus_data data;
+        if(wlen - 1 > I2C_SMBUS_BLOCK_MAX || selectSlave(addr) == false)
+        {
+           return false;
+        }
+        args.read_write = I2C_SMBUS_WRITE;
+        args.command = wbuf[0];
+        args.data = &data;
+        if(wlen == 1)
+        {
+           args.size = I2C_SMBUS_BYTE;        //set the register pointer only
+        }
+        else
+        {
+           args.size = I2C_SMBUS_I2C_BLOCK_DATA;
+           data.block[0] = wlen - 1;
+           memcpy(&data.block[1], &wbuf[1], wlen - 1);
+        }
+        return ioctl(_fd, I2C_SMBUS, &args) >= 0;
+     }
+     struct i2c_msg msg;
+     struct i2c_rdwr_ioctl_data xfer;
+     msg.addr  = addr;
+     msg.flags = 0;
+     msg.len   = wlen;
+     msg.buf   = (uint8_t *)wbuf;
+     xfer.msgs  = &msg;
+     xfer.nmsgs = 1;
+     return ioctl(_fd, I2C_RDWR, &xfer) >= 0;
+}
+/**********************************************************
+Description: write data then read from the device
+Parameters:  addr:7bit IIC address
+             wbuf[]:Variables for storing Data to be sent
+             wlen:Length of data sent
+             rbuf[]:Variables for storing Data to be obtained
+             rlen:Length of data to be obtained
+Return:      true:rlen bytes received  false:rbuf unchanged
+Others:      One ioctl, repeated start between write and read
+**********************************************************/
+bool BMS33M332LinuxBus::writeRead(uint8_t addr, const uint8_t wbuf[], uint8_t wlen,
+                                  uint8_t rbuf[], uint8_t rlen)
+{
+     if(_fd < 0 || wlen == 0)
+     {
+        return false;
+     }
+     if(_smbusOnly)
+     {
+        struct i2c_smbus_ioctl_data args;
+        union i2c_smbus_data data;
+        if(wlen != 1 || rlen > I2C_SMBUS_BLOCK_MAX || selectSlave(addr) == false)
+        {
+           return false;
+        }
+        args.read_write = I2C_SMBUS_READ;
+        args.command = wbuf[0];
+        args.size = I2C_SMBUS_I2C_BLOCK_DATA;
+        args.data = &data;
+        data.block[0] = rlen;
+        if(ioctl(_fd, I2C_SMBUS, &args) < 0 || data.block[0] != rlen)
+        {
+           return false;
+        }
+        memcpy(rbuf, &data.block[1], rlen);
+        return true;
+     }
+     uint8_t buf[I2C_SMBUS_BLOCK_MAX];
+     struct i2c_msg msgs[2];
+     struct i2c_rdwr_ioctl_data xfer;
+     if(rlen > sizeof(buf))
+     {
+        return false;
+     }
+     msgs[0].addr  = addr;
+     msgs[0].flags = 0;
+     msgs[0].len   = wlen;
+     msgs[0].buf   = (uint8_t *)wbuf;
+     msgs[1].addr  = addr;
+     msgs[1].flags = I2C_M_RD;
+     msgs[1].len   = rlen;
+     msgs[1].buf   = buf;
+     xfer.msgs  = msgs;
+     xfer.nmsgs = 2;
+     if(ioctl(_fd, I2C_RDWR, &xfer) < 0)
+     {
+        return false;
+     }
+     memcpy(rbuf, buf, rlen);
+     return true;
+}
+/**********************************************************
+Description: select the slave address of SMBus transfers
+Parameters:  addr:7bit IIC address
+Return:      true:success
+Others:      The ioctl is only issued when the address changes
+**********************************************************/
+bool BMS33M332LinuxBus::selectSlave(uint8_t addr)
+{
+     if(_slaveAddr != addr)
+     {
+        if(ioctl(_fd, I2C_SLAVE, addr) < 0)
+        {
+           return false;
+        }
+        _slaveAddr = addr;
+     }
+     return true;
+}
+
+#endif
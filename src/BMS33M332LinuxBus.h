@@ -0,0 +1,32 @@
+/*****************************************************************
+File:             BMS33M332LinuxBus.h
+Author:           BESTMODULES
+Description:      Linux i2c-dev(/dev/i2c-N) implementation of
+                  BMS33M332Bus, for single board computers
+******************************************************************/
+
+#ifndef _BMS33M332LINUXBUS_H_
+#define _BMS33M332LINUXBUS_H_
+
+#include "BMS33M332Bus.h"
+
+class BMS33M332LinuxBus : public BMS33M332Bus
+{
+   public:
+   BMS33M332LinuxBus(const char *device = "/dev/i2c-1");
+   ~BMS33M332LinuxBus();
+   void begin();
+   bool isOpen();
+   bool write(uint8_t addr, const uint8_t wbuf[], uint8_t wlen);
+   bool writeRead(uint8_t addr, const uint8_t wbuf[], uint8_t wlen,
+                  uint8_t rbuf[], uint8_t rlen);
+
+   private:
+   bool selectSlave(uint8_t addr);
+   const char *_device;
+   int  _fd = -1;
+   bool _smbusOnly = false;   //adapter without I2C_FUNC_I2C, e.g. i2c-stub
+   int  _slaveAddr = -1;
+};
+
+#endif
@@ -0,0 +1,63 @@
+/*****************************************************************
+File:             BMS33M332Port.h
+Author:           BESTMODULES
+Description:      The few Arduino core functions the library uses, for
+                  builds without the Arduino core(e.g. Linux SBCs).
+                  Internal: only included by the library .cpp files, so
+                  user code and GPIO libraries(e.g. wiringPi) declaring
+                  the same names are not affected.
+******************************************************************/
+
+#ifndef _BMS33M332PORT_H_
+#define _BMS33M332PORT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+namespace BMS33M332Port
+{
+const uint8_t INPUT = 0x0;
+const uint8_t LOW   = 0x0;
+const uint8_t HIGH  = 0x1;
+
+static inline unsigned long micros()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (unsigned long)(uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+static inline unsigned long millis()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (unsigned long)(uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static inline void delay(unsigned long ms)
+{
+   struct timespec ts;
+   ts.tv_sec  = ms / 1000;
+   ts.tv_nsec = (long)(ms % 1000) * 1000000;
+   nanosleep(&ts, NULL);
+}
+
+/*No GPIO access: the INT pin reads HIGH(no interrupt), poll FLAG_REG instead*/
+static inline void pinMode(uint8_t pin, uint8_t mode)
+{
+   (void)pin;
+   (void)mode;
+}
+
+static inline int digitalRead(uint8_t pin)
+{
+   (void)pin;
+   return HIGH;
+}
+
+}
+
+using namespace BMS33M332Port;
+
+#endif
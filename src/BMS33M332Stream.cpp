@@ -0,0 +1,96 @@
+/*****************************************************************
+File:        BMS33M332Stream.cpp
+Author:      BESTMODULES
+Description: Binary telemetry frame encoder
+******************************************************************/
+#include "BMS33M332Stream.h"
+/**********************************************************
+Description: Constructor
+Parameters:  out        :Serial or any BMS33M332Print object the frames are sent to
+             keyInterval:a key record(absolute values) every keyInterval
+                         records, so a decoder can resync after loss
+Return:      none
+Others:      none
+**********************************************************/
+BMS33M332Stream::BMS33M332Stream(BMS33M332Print *out,uint8_t keyInterval)
+{
+     _out = out;
+     _keyInterval = (keyInterval == 0) ? 1 : keyInterval;
+}
+/**********************************************************
+Description: encode one sample and send the frame
+Parameters:  time :sample time(unit:us), e.g. micros()
+             ps   :PS raw data
+             als  :ALS raw data
+             flags:FLAG_REG or readRawIfReady() data ready mask
+Return:      Number of bytes sent
+Others:      none
+**********************************************************/
+uint8_t BMS33M332Stream::write(uint32_t time,uint16_t ps,uint16_t als,uint8_t flags)
+{
+      uint8_t frame[BMS33M332_FRAME_MAX_LEN];
+      uint8_t len = encode(frame, time, ps, als, flags);
+      return _out->write(frame, len);
+}
+/**********************************************************
+Description: encode one sample into a frame
+Parameters:  frame:buffer of at least BMS33M332_FRAME_MAX_LEN bytes
+             time :sample time(unit:us)
+             ps   :PS raw data
+             als  :ALS raw data
+             flags:FLAG_REG or readRawIfReady() data ready mask
+Return:      Frame length
+Others:      Use this instead of write() to send frames on another
+             transport; the delta state advances the same way.
+**********************************************************/
+uint8_t BMS33M332Stream::encode(uint8_t frame[],uint32_t time,uint16_t ps,uint16_t als,uint8_t flags)
+{
+      uint8_t *payload = &frame[3];
+      uint8_t len = 0;
+      uint8_t crc = 0;
+      bool key = (_hasPrev == false) || (_sinceKey >= _keyInterval);
+      payload[len++] = (key ? BMS33M332_FRAME_KEY : 0) | (_seq & BMS33M332_FRAME_SEQ_MASK);
+      if(key)
+      {
+            len += bms33m332PutVarint(&payload[len], time);
+            payload[len++] = flags;
+            len += bms33m332PutVarint(&payload[len], ps);
+            len += bms33m332PutVarint(&payload[len], als);
+            _sinceKey = 0;
+      }
+      else
+      {
+            len += bms33m332PutVarint(&payload[len], time - _prevTime);
+            payload[len++] = flags;
+            len += bms33m332PutVarint(&payload[len], bms33m332ZigZag((int32_t)ps - _prevPs));
+            len += bms33m332PutVarint(&payload[len], bms33m332ZigZag((int32_t)als - _prevAls));
+      }
+      _sinceKey++;
+      _seq++;
+      _hasPrev  = true;
+      _prevTime = time;
+      _prevPs   = ps;
+      _prevAls  = als;
+
+      frame[0] = BMS33M332_FRAME_SYNC0;
+      frame[1] = BMS33M332_FRAME_SYNC1;
+      frame[2] = len;
+      for(uint8_t i = 2; i < 3 + len; i++)
+      {
+            crc = bms33m332Crc8(crc, frame[i]);
+      }
+      frame[3 + len] = crc;
+      return 3 + len + 1;
+}
+/**********************************************************
+Description: restart the stream
+Parameters:  none
+Return:      none
+Others:      The next record is a key record
+**********************************************************/
+void BMS33M332Stream::reset()
+{
+      _seq = 0;
+      _sinceKey = 0;
+      _hasPrev = false;
+}
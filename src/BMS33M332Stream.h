@@ -0,0 +1,55 @@
+/*****************************************************************
+File:             BMS33M332Stream.h
+Author:           BESTMODULES
+Description:      Encode BMS33M332 samples into compact binary frames
+                  (see BMS33M332Frame.h) for serial or radio links
+******************************************************************/
+
+#ifndef _BMS33M332STREAM_H_
+#define _BMS33M332STREAM_H_
+
+#include "BMS33M332Frame.h"
+#if defined(ARDUINO)
+#include <Arduino.h>
+typedef Print BMS33M332Print;   //Serial or any Arduino Print object
+#else
+#include <stddef.h>
+/*Output interface of BMS33M332Stream without the Arduino core*/
+class BMS33M332Print
+{
+   public:
+   virtual ~BMS33M332Print() {}
+   virtual size_t write(uint8_t data) = 0;
+   virtual size_t write(const uint8_t *buf, size_t len)
+   {
+      size_t n = 0;
+      while(len-- > 0)
+      {
+         n += write(*buf++);
+      }
+      return n;
+   }
+};
+#endif
+
+class BMS33M332Stream
+{
+   public:
+   BMS33M332Stream(BMS33M332Print *out,uint8_t keyInterval = 32);
+
+   uint8_t write(uint32_t time,uint16_t ps,uint16_t als,uint8_t flags);
+   uint8_t encode(uint8_t frame[],uint32_t time,uint16_t ps,uint16_t als,uint8_t flags);
+   void reset();
+
+   private:
+   BMS33M332Print *_out;
+   uint8_t _keyInterval;
+   uint8_t _seq      = 0;
+   uint8_t _sinceKey = 0;
+   bool    _hasPrev  = false;
+   uint32_t _prevTime = 0;
+   uint16_t _prevPs   = 0;
+   uint16_t _prevAls  = 0;
+};
+
+#endif